@@ -85,9 +85,15 @@ int main(int argc, char* argv[]) {
         std::cout << "- POST /api/messages/send: 发送消息" << std::endl;
         std::cout << "- GET  /api/messages: 获取消息列表" << std::endl;
         std::cout << "- POST /api/messages/mark_read: 标记消息已读" << std::endl;
+        std::cout << "- GET  /api/messages/unread: 获取未读消息数" << std::endl;
         std::cout << "通知服务:" << std::endl;
         std::cout << "- POST /api/notifications/send: 发送通知" << std::endl;
+        std::cout << "- POST /api/notifications/send_bulk: 批量发送通知" << std::endl;
         std::cout << "- GET  /api/notifications: 获取通知列表" << std::endl;
+        std::cout << "- GET  /api/notifications/stream: 推送新通知（Server-Sent Events），"
+                  << "同时保持的推送流上限由CHAT_GATEWAY_MAX_STREAMS设置" << std::endl;
+        std::cout << "认证: 除注册、登录外的请求可携带 Authorization: Bearer <token>，"
+                  << "设置CHAT_GATEWAY_REQUIRE_AUTH=1后必须携带" << std::endl;
         std::cout << "特性: HTTP到TCP上下文自动转换，31字节高效传输" << std::endl;
         std::cout << "按 Ctrl+C 停止服务" << std::endl;
         
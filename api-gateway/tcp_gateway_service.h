@@ -5,14 +5,64 @@
 #include <memory>
 #include <iostream>
 #include <functional>
+#include <algorithm>
 #include <map>
 #include <regex>
+#include <cstdlib>
 
 #include "../third_party/httplib.h"
 #include "../common/telemetry.h"
 #include "../common/context_propagation.h"
 #include "../common/tcp_context_propagation.h"
+#include "../common/tcp_multiplexed_channel.h"
 #include "../common/models.h"
+#include "../common/id128.h"
+#include "token_cache.h"
+
+/**
+ * @brief 网关认证参数
+ */
+struct GatewayAuthOptions {
+    bool require_token = false;   // 为true时除注册、登录外的请求都必须携带有效令牌
+    TokenCacheOptions cache;
+
+    /**
+     * @brief 从环境变量读取参数：CHAT_GATEWAY_REQUIRE_AUTH=1 时强制认证
+     */
+    static GatewayAuthOptions FromEnvironment() {
+        GatewayAuthOptions options;
+        const char* require = std::getenv("CHAT_GATEWAY_REQUIRE_AUTH");
+        if (require != nullptr) {
+            std::string value = require;
+            options.require_token = value == "1" || value == "true";
+        }
+        return options;
+    }
+};
+
+/**
+ * @brief 通知推送流参数
+ * 每个推送流在连接存续期间占用一个HTTP线程，线程池按推送流上限加上留给其他路由的线程数分配
+ */
+struct GatewayStreamOptions {
+    size_t max_streams = 256;     // 同时保持的推送流上限，超出时返回503
+
+    /**
+     * @brief 从环境变量读取参数：CHAT_GATEWAY_MAX_STREAMS 设置推送流上限
+     */
+    static GatewayStreamOptions FromEnvironment() {
+        GatewayStreamOptions options;
+        const char* max_streams = std::getenv("CHAT_GATEWAY_MAX_STREAMS");
+        if (max_streams != nullptr) {
+            char* end = nullptr;
+            unsigned long long value = std::strtoull(max_streams, &end, 10);
+            if (end != max_streams && *end == '\0') {
+                options.max_streams = static_cast<size_t>(value);
+            }
+        }
+        return options;
+    }
+};
 
 /**
  * @brief TCP网关服务类
@@ -27,14 +77,24 @@ public:
                       const std::string& host, int port,
                       const std::string& user_service_host, int user_service_port,
                       const std::string& message_service_host, int message_service_port,
-                      const std::string& notification_service_host, int notification_service_port)
+                      const std::string& notification_service_host, int notification_service_port,
+                      const GatewayAuthOptions& auth_options = GatewayAuthOptions::FromEnvironment(),
+                      const GatewayStreamOptions& stream_options = GatewayStreamOptions::FromEnvironment())
         : service_name_(service_name), service_version_(service_version),
           host_(host), port_(port), running_(false),
           user_service_host_(user_service_host), user_service_port_(user_service_port),
           message_service_host_(message_service_host), message_service_port_(message_service_port),
-          notification_service_host_(notification_service_host), notification_service_port_(notification_service_port) {
+          notification_service_host_(notification_service_host), notification_service_port_(notification_service_port),
+          auth_options_(auth_options), token_cache_(auth_options.cache),
+          max_streams_(stream_options.max_streams),
+          http_threads_(max_streams_ + std::max<size_t>(CPPHTTPLIB_THREAD_POOL_COUNT, kReservedHttpThreads)),
+          active_streams_(0) {
         
         server_ = std::make_unique<httplib::Server>();
+        // 每个通知推送流在连接存续期间占用一个线程，推送流占满时其他路由仍有保留的线程可用
+        server_->new_task_queue = [this]() {
+            return new httplib::ThreadPool(http_threads_);
+        };
         SetupMiddleware();
     }
 
@@ -61,6 +121,8 @@ public:
         std::cout << "- 用户服务: " << user_service_host_ << ":" << user_service_port_ << std::endl;
         std::cout << "- 消息服务: " << message_service_host_ << ":" << message_service_port_ << std::endl;
         std::cout << "- 通知服务: " << notification_service_host_ << ":" << notification_service_port_ << std::endl;
+        std::cout << "强制令牌认证: " << (auth_options_.require_token ? "是" : "否") << std::endl;
+        std::cout << "推送流上限: " << max_streams_ << "，HTTP线程数: " << http_threads_ << std::endl;
         
         // 启动HTTP服务器
         server_thread_ = std::thread([this]() {
@@ -142,6 +204,7 @@ private:
             CreateTcpHandler<chat::models::LoginRequest, chat::models::LoginResponse>(
                 "gateway.user_login", user_service_host_, user_service_port_, "user.login"));
         
+        // 以下路由携带令牌时先认证；请求中代表某个用户的字段必须与令牌所属用户一致
         server_->Get("/api/users/(.*)", 
             CreateTcpGetHandler<chat::models::UserInfo, chat::models::GetUserRequest>(
                 "gateway.user_get", user_service_host_, user_service_port_, "user.get",
@@ -154,12 +217,14 @@ private:
                         return request;
                     }
                     throw std::runtime_error("无效的用户ID");
-                }));
+                },
+                AnyUser<chat::models::GetUserRequest>()));
 
         // 消息服务路由
         server_->Post("/api/messages/send",
             CreateTcpHandler<chat::models::SendMessageRequest, chat::models::SendMessageResponse>(
-                "gateway.message_send", message_service_host_, message_service_port_, "message.send"));
+                "gateway.message_send", message_service_host_, message_service_port_, "message.send",
+                [](const chat::models::SendMessageRequest& request) { return request.sender_id; }));
         
         server_->Get("/api/messages",
             CreateTcpGetHandler<chat::models::GetMessagesResponse, chat::models::GetMessagesRequest>(
@@ -171,17 +236,39 @@ private:
                     if (req.has_param("limit")) {
                         request.limit = std::stoi(req.get_param_value("limit"));
                     }
+                    if (req.has_param("before_timestamp")) {
+                        request.before_timestamp = std::stoll(req.get_param_value("before_timestamp"));
+                    }
+                    request.before_message_id = req.get_param_value("before_message_id");
                     return request;
-                }));
+                },
+                [](const chat::models::GetMessagesRequest& request) { return request.user_id; }));
         
         server_->Post("/api/messages/mark_read",
             CreateTcpHandler<chat::models::MarkMessageReadRequest, chat::models::MarkMessageReadResponse>(
-                "gateway.message_mark_read", message_service_host_, message_service_port_, "message.mark_read"));
+                "gateway.message_mark_read", message_service_host_, message_service_port_, "message.mark_read",
+                [](const chat::models::MarkMessageReadRequest& request) { return request.user_id; }));
+        
+        server_->Get("/api/messages/unread",
+            CreateTcpGetHandler<chat::models::GetUnreadCountsResponse, chat::models::GetUnreadCountsRequest>(
+                "gateway.message_unread_counts", message_service_host_, message_service_port_, "message.unread_counts",
+                [](const httplib::Request& req) -> chat::models::GetUnreadCountsRequest {
+                    chat::models::GetUnreadCountsRequest request;
+                    request.user_id = req.get_param_value("user_id");
+                    return request;
+                },
+                [](const chat::models::GetUnreadCountsRequest& request) { return request.user_id; }));
 
         // 通知服务路由
         server_->Post("/api/notifications/send",
             CreateTcpHandler<chat::models::NotificationRequest, chat::models::NotificationResponse>(
-                "gateway.notification_send", notification_service_host_, notification_service_port_, "notification.send"));
+                "gateway.notification_send", notification_service_host_, notification_service_port_, "notification.send",
+                AnyUser<chat::models::NotificationRequest>()));
+        
+        server_->Post("/api/notifications/send_bulk",
+            CreateTcpHandler<chat::models::BulkNotificationRequest, chat::models::BulkNotificationResponse>(
+                "gateway.notification_send_bulk", notification_service_host_, notification_service_port_,
+                "notification.send_bulk", AnyUser<chat::models::BulkNotificationRequest>()));
         
         server_->Get("/api/notifications",
             CreateTcpGetHandler<chat::models::GetNotificationsResponse, chat::models::GetNotificationsRequest>(
@@ -192,8 +279,133 @@ private:
                     if (req.has_param("limit")) {
                         request.limit = std::stoi(req.get_param_value("limit"));
                     }
+                    if (req.has_param("before_timestamp")) {
+                        request.before_timestamp = std::stoll(req.get_param_value("before_timestamp"));
+                    }
+                    if (req.has_param("before_sequence")) {
+                        request.before_sequence = std::stoll(req.get_param_value("before_sequence"));
+                    }
                     return request;
-                }));
+                },
+                [](const chat::models::GetNotificationsRequest& request) { return request.user_id; }));
+        
+        server_->Get("/api/notifications/stream", [this](const httplib::Request& req, httplib::Response& res) {
+            StreamNotifications(req, res);
+        });
+    }
+
+    /**
+     * @brief 以Server-Sent Events推送用户的新通知
+     * 连接存续期间循环调用notification.subscribe长轮询，每条通知写为一个事件，事件ID为通知序号；
+     * 客户端重连时通过Last-Event-ID（或cursor参数）从断开处继续，等待超时时写注释行保活。
+     * 推送流同时存在的数量有上限，为其他路由保留线程，达到上限时返回503
+     */
+    void StreamNotifications(const httplib::Request& req, httplib::Response& res) {
+        auto http_context_token = context_propagation::ExtractHttpContext(req);
+        
+        auto scope = CreateSpan("gateway.notification_stream");
+        auto span = GetCurrentSpan();
+        
+        if (span->IsRecording()) {
+            span->SetAttribute("http.method", req.method);
+            span->SetAttribute("http.url", req.path);
+            span->SetAttribute("service.name", service_name_);
+            span->SetAttribute("backend.message_type", "notification.subscribe");
+            span->SetAttribute("protocol.frontend", "http");
+            span->SetAttribute("protocol.backend", "tcp");
+        }
+        
+        try {
+            chat::models::SubscribeNotificationsRequest request;
+            request.user_id = req.get_param_value("user_id");
+            request.wait_ms = kStreamWaitMs;
+            std::string last_event_id = req.get_header_value("Last-Event-ID");
+            if (!last_event_id.empty()) {
+                request.cursor = std::stoll(last_event_id);
+            } else if (req.has_param("cursor")) {
+                request.cursor = std::stoll(req.get_param_value("cursor"));
+            }
+            
+            if (!Authorize(req, res, request.user_id)) {
+                return;
+            }
+            
+            if (active_streams_.fetch_add(1) >= max_streams_) {
+                active_streams_.fetch_sub(1);
+                res.set_header("Retry-After", "5");
+                RejectRequest(res, 503, "推送连接数已达上限，请稍后重试");
+                return;
+            }
+            
+            res.set_header("Cache-Control", "no-cache");
+            res.set_chunked_content_provider("text/event-stream",
+                [this, request](size_t, httplib::DataSink& sink) mutable {
+                    if (!running_) {
+                        sink.done();
+                        return true;
+                    }
+                    std::string events;
+                    try {
+                        auto response = SendTcpRequest<chat::models::SubscribeNotificationsRequest,
+                                                       chat::models::SubscribeNotificationsResponse>(
+                            notification_service_host_, notification_service_port_, "notification.subscribe", request);
+                        if (!response.success) {
+                            events = "event: error\ndata: " + nlohmann::json(response).dump() + "\n\n";
+                            sink.write(events.data(), events.size());
+                            sink.done();
+                            return true;
+                        }
+                        
+                        // 返回的通知序号连续，最后一条为response.cursor
+                        int64_t sequence = response.cursor - static_cast<int64_t>(response.notifications.size());
+                        for (const auto& notification : response.notifications) {
+                            events += "id: " + std::to_string(++sequence) + "\nevent: notification\ndata: " +
+                                      nlohmann::json(notification).dump() + "\n\n";
+                        }
+                        if (events.empty()) {
+                            events = ": keepalive\n\n";
+                        }
+                        request.cursor = response.cursor;
+                    } catch (const std::exception& e) {
+                        nlohmann::json error_response = {
+                            {"success", false},
+                            {"message", e.what()}
+                        };
+                        events = "event: error\ndata: " + error_response.dump() + "\n\n";
+                        sink.write(events.data(), events.size());
+                        sink.done();
+                        return true;
+                    }
+                    return sink.write(events.data(), events.size());
+                },
+                [this](bool) {
+                    // 响应对象析构时调用，无论推送流如何结束都会释放名额
+                    active_streams_.fetch_sub(1);
+                });
+            
+            span->SetStatus(trace::StatusCode::kOk);
+            
+        } catch (const std::exception& e) {
+            span->SetStatus(trace::StatusCode::kError, e.what());
+            nlohmann::json error_response = {
+                {"success", false},
+                {"message", e.what()}
+            };
+            res.set_content(error_response.dump(), "application/json");
+            res.status = 500;
+        }
+    }
+
+    /**
+     * @brief 请求代表的用户：返回请求中的用户ID，返回空串表示任意已认证用户均可
+     * 路由不提供时为公开接口（注册、登录），不做认证
+     */
+    template<typename RequestType>
+    using SubjectOf = std::function<std::string(const RequestType&)>;
+
+    template<typename RequestType>
+    static SubjectOf<RequestType> AnyUser() {
+        return [](const RequestType&) { return std::string(); };
     }
 
     /**
@@ -203,8 +415,9 @@ private:
     std::function<void(const httplib::Request&, httplib::Response&)> 
     CreateTcpHandler(const std::string& operation_name,
                      const std::string& tcp_host, int tcp_port,
-                     const std::string& message_type) {
-        return [this, operation_name, tcp_host, tcp_port, message_type]
+                     const std::string& message_type,
+                     SubjectOf<RequestType> subject_of = nullptr) {
+        return [this, operation_name, tcp_host, tcp_port, message_type, subject_of]
                (const httplib::Request& req, httplib::Response& res) {
             
             // 提取HTTP追踪上下文并转换为TCP上下文
@@ -214,13 +427,15 @@ private:
             auto scope = CreateSpan(operation_name);
             auto span = GetCurrentSpan();
             
-            span->SetAttribute("http.method", req.method);
-            span->SetAttribute("http.url", req.path);
-            span->SetAttribute("service.name", service_name_);
-            span->SetAttribute("backend.service", tcp_host + ":" + std::to_string(tcp_port));
-            span->SetAttribute("backend.message_type", message_type);
-            span->SetAttribute("protocol.frontend", "http");
-            span->SetAttribute("protocol.backend", "tcp");
+            if (span->IsRecording()) {
+                span->SetAttribute("http.method", req.method);
+                span->SetAttribute("http.url", req.path);
+                span->SetAttribute("service.name", service_name_);
+                span->SetAttribute("backend.service", tcp_host + ":" + std::to_string(tcp_port));
+                span->SetAttribute("backend.message_type", message_type);
+                span->SetAttribute("protocol.frontend", "http");
+                span->SetAttribute("protocol.backend", "tcp");
+            }
             
             try {
                 // 解析HTTP请求
@@ -230,6 +445,11 @@ private:
                     request = json_data.get<RequestType>();
                 }
                 
+                // 认证令牌并校验请求代表的用户
+                if (subject_of && !Authorize(req, res, subject_of(request))) {
+                    return;
+                }
+                
                 // 通过TCP调用后端服务
                 span->AddEvent("calling_backend_service");
                 auto response = SendTcpRequest<RequestType, ResponseType>(tcp_host, tcp_port, message_type, request);
@@ -245,10 +465,12 @@ private:
             } catch (const std::exception& e) {
                 // 记录异常
                 span->SetStatus(trace::StatusCode::kError, e.what());
-                span->AddEvent("backend_call_failed", {
-                    {"exception.type", typeid(e).name()},
-                    {"exception.message", e.what()}
-                });
+                if (span->IsRecording()) {
+                    span->AddEvent("backend_call_failed", {
+                        {"exception.type", typeid(e).name()},
+                        {"exception.message", e.what()}
+                    });
+                }
                 
                 nlohmann::json error_response = {
                     {"success", false},
@@ -268,8 +490,9 @@ private:
     CreateTcpGetHandler(const std::string& operation_name,
                         const std::string& tcp_host, int tcp_port,
                         const std::string& message_type,
-                        std::function<RequestType(const httplib::Request&)> request_builder) {
-        return [this, operation_name, tcp_host, tcp_port, message_type, request_builder]
+                        std::function<RequestType(const httplib::Request&)> request_builder,
+                        SubjectOf<RequestType> subject_of = nullptr) {
+        return [this, operation_name, tcp_host, tcp_port, message_type, request_builder, subject_of]
                (const httplib::Request& req, httplib::Response& res) {
             
             // 提取HTTP追踪上下文
@@ -279,18 +502,25 @@ private:
             auto scope = CreateSpan(operation_name);
             auto span = GetCurrentSpan();
             
-            span->SetAttribute("http.method", req.method);
-            span->SetAttribute("http.url", req.path);
-            span->SetAttribute("service.name", service_name_);
-            span->SetAttribute("backend.service", tcp_host + ":" + std::to_string(tcp_port));
-            span->SetAttribute("backend.message_type", message_type);
-            span->SetAttribute("protocol.frontend", "http");
-            span->SetAttribute("protocol.backend", "tcp");
+            if (span->IsRecording()) {
+                span->SetAttribute("http.method", req.method);
+                span->SetAttribute("http.url", req.path);
+                span->SetAttribute("service.name", service_name_);
+                span->SetAttribute("backend.service", tcp_host + ":" + std::to_string(tcp_port));
+                span->SetAttribute("backend.message_type", message_type);
+                span->SetAttribute("protocol.frontend", "http");
+                span->SetAttribute("protocol.backend", "tcp");
+            }
             
             try {
                 // 构建请求
                 auto request = request_builder(req);
                 
+                // 认证令牌并校验请求代表的用户
+                if (subject_of && !Authorize(req, res, subject_of(request))) {
+                    return;
+                }
+                
                 // 通过TCP调用后端服务
                 span->AddEvent("calling_backend_service");
                 auto response = SendTcpRequest<RequestType, ResponseType>(tcp_host, tcp_port, message_type, request);
@@ -306,10 +536,12 @@ private:
             } catch (const std::exception& e) {
                 // 记录异常
                 span->SetStatus(trace::StatusCode::kError, e.what());
-                span->AddEvent("backend_call_failed", {
-                    {"exception.type", typeid(e).name()},
-                    {"exception.message", e.what()}
-                });
+                if (span->IsRecording()) {
+                    span->AddEvent("backend_call_failed", {
+                        {"exception.type", typeid(e).name()},
+                        {"exception.message", e.what()}
+                    });
+                }
                 
                 nlohmann::json error_response = {
                     {"success", false},
@@ -322,86 +554,77 @@ private:
     }
 
     /**
-     * @brief 发送TCP请求到后端服务
-     * 这里关键是将当前的HTTP追踪上下文转换为TCP追踪上下文
+     * @brief 认证请求携带的Bearer令牌，并校验令牌所属用户与请求代表的用户一致
+     * 未携带令牌时只有在强制认证模式下才拒绝；令牌先查本地缓存，未命中时调用user.auth
+     * @param subject 请求代表的用户ID，为空表示任意已认证用户均可
+     * @return 不通过时已写入401/403响应
+     * @throws std::runtime_error user-service不可用
      */
-    template<typename RequestType, typename ResponseType>
-    ResponseType SendTcpRequest(const std::string& host, int port,
-                               const std::string& message_type,
-                               const RequestType& request) {
-        // 创建连接
-        int client_socket = socket(AF_INET, SOCK_STREAM, 0);
-        if (client_socket < 0) {
-            throw std::runtime_error("创建客户端socket失败");
+    bool Authorize(const httplib::Request& req, httplib::Response& res, const std::string& subject) {
+        auto span = GetCurrentSpan();
+        std::string token = BearerToken(req);
+        if (token.empty()) {
+            if (!auth_options_.require_token) {
+                return true;
+            }
+            RejectRequest(res, 401, "缺少认证令牌");
+            return false;
         }
         
-        sockaddr_in server_addr{};
-        server_addr.sin_family = AF_INET;
-        server_addr.sin_addr.s_addr = inet_addr(host.c_str());
-        server_addr.sin_port = htons(port);
-        
-        if (connect(client_socket, (sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
-            close(client_socket);
-            throw std::runtime_error("连接服务失败");
+        span->AddEvent("authenticating");
+        chat::Id128 user_id;
+        bool valid = token_cache_.Verify(token, user_id, [&](chat::Id128& id) {
+            chat::models::AuthRequest request;
+            request.token = token;
+            auto response = SendTcpRequest<chat::models::AuthRequest, chat::models::AuthResponse>(
+                user_service_host_, user_service_port_, "user.auth", request);
+            return response.success && chat::Id128::Parse(response.user_id, id);
+        });
+        if (!valid) {
+            RejectRequest(res, 401, "认证令牌无效");
+            return false;
         }
         
-        try {
-            // *** 关键：获取当前追踪上下文并转换为TCP格式 ***
-            auto trace_data = tcp_context_propagation::GetCurrentTraceContextBinary();
-            
-            // 构造消息格式: [trace_data_size(4)][trace_data][msg_type_size(4)][msg_type][data_size(4)][data]
-            std::vector<uint8_t> message;
-            
-            // 追踪数据大小
-            uint32_t trace_size = htonl(static_cast<uint32_t>(trace_data.size()));
-            message.insert(message.end(), (uint8_t*)&trace_size, (uint8_t*)&trace_size + 4);
-            
-            // 追踪数据
-            message.insert(message.end(), trace_data.begin(), trace_data.end());
-            
-            // 消息类型大小
-            uint32_t msg_type_size = htonl(static_cast<uint32_t>(message_type.size()));
-            message.insert(message.end(), (uint8_t*)&msg_type_size, (uint8_t*)&msg_type_size + 4);
-            
-            // 消息类型
-            message.insert(message.end(), message_type.begin(), message_type.end());
-            
-            // 序列化请求数据
-            nlohmann::json json_request = request;
-            auto request_str = json_request.dump();
-            std::vector<uint8_t> request_data(request_str.begin(), request_str.end());
-            
-            // 数据大小
-            uint32_t data_size = htonl(static_cast<uint32_t>(request_data.size()));
-            message.insert(message.end(), (uint8_t*)&data_size, (uint8_t*)&data_size + 4);
-            
-            // 数据
-            message.insert(message.end(), request_data.begin(), request_data.end());
-            
-            // 发送消息
-            send(client_socket, message.data(), message.size(), 0);
-            
-            // 接收响应大小
-            uint32_t response_size;
-            recv(client_socket, &response_size, 4, MSG_WAITALL);
-            response_size = ntohl(response_size);
-            
-            // 接收响应数据
-            std::vector<uint8_t> response_data(response_size);
-            recv(client_socket, response_data.data(), response_size, MSG_WAITALL);
-            
-            // 反序列化响应
-            auto json_str = std::string(response_data.begin(), response_data.end());
-            auto json_data = nlohmann::json::parse(json_str);
-            ResponseType response = json_data.get<ResponseType>();
-            
-            close(client_socket);
-            return response;
-            
-        } catch (...) {
-            close(client_socket);
-            throw;
+        chat::Id128 subject_id;
+        if (!subject.empty() && (!chat::Id128::Parse(subject, subject_id) || subject_id != user_id)) {
+            RejectRequest(res, 403, "无权代表其他用户操作");
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief 取出"Authorization: Bearer <token>"中的令牌，未携带时返回空串
+     */
+    static std::string BearerToken(const httplib::Request& req) {
+        const std::string prefix = "Bearer ";
+        std::string header = req.get_header_value("Authorization");
+        if (header.size() <= prefix.size() || header.compare(0, prefix.size(), prefix) != 0) {
+            return std::string();
         }
+        return header.substr(prefix.size());
+    }
+
+    void RejectRequest(httplib::Response& res, int status, const std::string& message) {
+        GetCurrentSpan()->SetStatus(trace::StatusCode::kError, message);
+        nlohmann::json error_response = {
+            {"success", false},
+            {"message", message}
+        };
+        res.set_content(error_response.dump(), "application/json");
+        res.status = status;
+    }
+
+    /**
+     * @brief 发送TCP请求到后端服务
+     * 这里关键是将当前的HTTP追踪上下文转换为TCP追踪上下文；
+     * 所有并发请求通过每个后端少量的多路复用连接发送，按请求ID取回各自的响应
+     */
+    template<typename RequestType, typename ResponseType>
+    ResponseType SendTcpRequest(const std::string& host, int port,
+                               const std::string& message_type,
+                               const RequestType& request) {
+        return tcp_client::SendMultiplexedRequest<RequestType, ResponseType>(host, port, message_type, request);
     }
 
 private:
@@ -421,6 +644,20 @@ private:
     int message_service_port_;
     std::string notification_service_host_;
     int notification_service_port_;
+    
+    // 令牌认证
+    GatewayAuthOptions auth_options_;
+    VerifiedTokenCache token_cache_;
+    
+    // 推送流单次长轮询的等待时间，低于调用后端的超时
+    static constexpr int32_t kStreamWaitMs = 25000;
+    // 推送流可同时占用的上限，以及HTTP线程池的线程数（上限加上保留给其他路由的线程）
+    size_t max_streams_;
+    size_t http_threads_;
+    std::atomic<size_t> active_streams_;
+    
+    // 不分给推送流、留给其他路由的最少线程数
+    static constexpr size_t kReservedHttpThreads = 16;
 };
 
 #endif // TCP_GATEWAY_SERVICE_H
\ No newline at end of file
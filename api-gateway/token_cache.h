@@ -0,0 +1,129 @@
+#ifndef TOKEN_CACHE_H
+#define TOKEN_CACHE_H
+
+#include <chrono>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../common/id128.h"
+
+/**
+ * @brief 令牌缓存参数
+ */
+struct TokenCacheOptions {
+    size_t capacity = 100000;                                 // 缓存的令牌数上限，超出后淘汰最久未用的
+    std::chrono::milliseconds positive_ttl{60000};            // 有效令牌的缓存时间
+    std::chrono::milliseconds negative_ttl{5000};             // 无效令牌的缓存时间，挡住反复使用错误令牌的请求
+    size_t shard_count = 16;
+};
+
+/**
+ * @brief 网关中已验证令牌的缓存
+ * 令牌命中时直接得到所属用户，认证请求不必再到user-service往返一次。
+ * 同时缓存有效与无效两种结果，各自有TTL；按令牌哈希分片，每个分片独立加锁并按LRU淘汰。
+ * 只缓存user-service明确给出的结果，网络错误不写入缓存
+ */
+class VerifiedTokenCache {
+public:
+    explicit VerifiedTokenCache(const TokenCacheOptions& options = TokenCacheOptions())
+        : options_(options), shards_(options.shard_count == 0 ? 1 : options.shard_count) {
+        shard_capacity_ = options_.capacity / shards_.size();
+        if (shard_capacity_ == 0) {
+            shard_capacity_ = 1;
+        }
+    }
+
+    /**
+     * @brief 查询缓存
+     * @param valid 命中时写入令牌是否有效
+     * @param user_id 命中且有效时写入令牌所属用户
+     * @return 未命中或已过期时返回false
+     */
+    bool Lookup(const std::string& token, bool& valid, chat::Id128& user_id) {
+        auto now = std::chrono::steady_clock::now();
+        Shard& shard = ShardFor(token);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(token);
+        if (it == shard.index.end()) {
+            return false;
+        }
+        if (it->second->expires_at <= now) {
+            shard.lru.erase(it->second);
+            shard.index.erase(it);
+            return false;
+        }
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        valid = it->second->valid;
+        user_id = it->second->user_id;
+        return true;
+    }
+
+    /**
+     * @brief 写入验证结果
+     */
+    void Store(const std::string& token, bool valid, const chat::Id128& user_id) {
+        auto expires_at = std::chrono::steady_clock::now() +
+                          (valid ? options_.positive_ttl : options_.negative_ttl);
+        Shard& shard = ShardFor(token);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(token);
+        if (it != shard.index.end()) {
+            it->second->valid = valid;
+            it->second->user_id = user_id;
+            it->second->expires_at = expires_at;
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+            return;
+        }
+
+        shard.lru.push_front(Entry{token, valid, user_id, expires_at});
+        shard.index.emplace(token, shard.lru.begin());
+        while (shard.index.size() > shard_capacity_) {
+            shard.index.erase(shard.lru.back().token);
+            shard.lru.pop_back();
+        }
+    }
+
+    /**
+     * @brief 先查缓存，未命中时调用fetch验证并缓存其结果
+     * @param fetch 向user-service验证令牌，有效时写入用户ID并返回true；抛出异常表示无法确定，结果不缓存
+     */
+    template<typename Fetch>
+    bool Verify(const std::string& token, chat::Id128& user_id, Fetch&& fetch) {
+        bool valid = false;
+        if (Lookup(token, valid, user_id)) {
+            return valid;
+        }
+        user_id = chat::Id128();
+        valid = fetch(user_id);
+        Store(token, valid, user_id);
+        return valid;
+    }
+
+private:
+    struct Entry {
+        std::string token;
+        bool valid;
+        chat::Id128 user_id;
+        std::chrono::steady_clock::time_point expires_at;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::list<Entry> lru;  // 头部为最近使用
+        std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    };
+
+    Shard& ShardFor(const std::string& token) {
+        return shards_[std::hash<std::string>()(token) % shards_.size()];
+    }
+
+    TokenCacheOptions options_;
+    std::vector<Shard> shards_;
+    size_t shard_capacity_;
+};
+
+#endif // TOKEN_CACHE_H
@@ -0,0 +1,212 @@
+#ifndef BATCH_SPAN_PROCESSOR_H
+#define BATCH_SPAN_PROCESSOR_H
+
+#include "opentelemetry/nostd/span.h"
+#include "opentelemetry/sdk/common/exporter_utils.h"
+#include "opentelemetry/sdk/trace/exporter.h"
+#include "opentelemetry/sdk/trace/processor.h"
+#include "opentelemetry/sdk/trace/recordable.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "mpmc_queue.h"
+
+/**
+ * @brief 批量导出参数
+ */
+struct BatchSpanOptions {
+    size_t max_queue_size = 4096;                  // 等待导出的span上限，队列满时直接丢弃新span
+    size_t max_export_batch_size = 512;            // 单次导出的最大span数
+    std::chrono::milliseconds flush_interval{1000}; // 不满一批时的最长等待时间
+};
+
+/**
+ * @brief 异步批量span处理器
+ * 请求线程结束span时只把它放进无锁有界队列，由后台线程攒批后导出，
+ * 导出端（如Zipkin）变慢时只会丢弃span，不会阻塞请求处理。丢弃数量会被统计并定期打印
+ */
+class AsyncBatchSpanProcessor : public opentelemetry::sdk::trace::SpanProcessor {
+public:
+    static constexpr std::chrono::milliseconds kMinFlushInterval{10};
+
+    AsyncBatchSpanProcessor(std::unique_ptr<opentelemetry::sdk::trace::SpanExporter> exporter,
+                            const BatchSpanOptions& options)
+        : exporter_(std::move(exporter)), options_(options), queue_(options.max_queue_size),
+          stopping_(false), flush_requested_(0), flush_completed_(0),
+          exported_count_(0), dropped_count_(0), failed_count_(0) {
+        if (options_.max_export_batch_size == 0) {
+            options_.max_export_batch_size = 1;
+        }
+        // 间隔为0（如OTEL_BSP_SCHEDULE_DELAY=0）时导出线程会空转
+        if (options_.flush_interval < kMinFlushInterval) {
+            options_.flush_interval = kMinFlushInterval;
+        }
+        worker_ = std::thread([this]() { ExportLoop(); });
+    }
+
+    ~AsyncBatchSpanProcessor() override {
+        Shutdown();
+    }
+
+    std::unique_ptr<opentelemetry::sdk::trace::Recordable> MakeRecordable() noexcept override {
+        return exporter_->MakeRecordable();
+    }
+
+    void OnStart(opentelemetry::sdk::trace::Recordable&,
+                 const opentelemetry::trace::SpanContext&) noexcept override {}
+
+    /**
+     * @brief 请求线程上唯一的开销：一次无锁入队；攒满一批时唤醒导出线程
+     */
+    void OnEnd(std::unique_ptr<opentelemetry::sdk::trace::Recordable>&& span) noexcept override {
+        if (stopping_.load(std::memory_order_relaxed) || !queue_.TryPush(std::move(span))) {
+            dropped_count_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (queue_.SizeApprox() >= options_.max_export_batch_size) {
+            cv_.notify_one();
+        }
+    }
+
+    /**
+     * @brief 导出当前队列中的全部span并等待完成
+     */
+    bool ForceFlush(std::chrono::microseconds timeout = (std::chrono::microseconds::max)()) noexcept override {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (stopping_.load()) {
+            return true;
+        }
+        uint64_t target = ++flush_requested_;
+        cv_.notify_one();
+        auto done = [this, target]() { return flush_completed_ >= target; };
+        if (timeout == (std::chrono::microseconds::max)()) {
+            flush_cv_.wait(lock, done);
+            return true;
+        }
+        return flush_cv_.wait_for(lock, timeout, done);
+    }
+
+    /**
+     * @brief 停止导出线程，导出剩余span后关闭导出器
+     */
+    bool Shutdown(std::chrono::microseconds timeout = (std::chrono::microseconds::max)()) noexcept override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_.exchange(true)) {
+                return true;
+            }
+        }
+        cv_.notify_one();
+        if (worker_.joinable()) {
+            worker_.join();
+        }
+
+        std::cout << "span导出统计: 已导出 " << exported_count_.load()
+                  << ", 队列满丢弃 " << dropped_count_.load()
+                  << ", 导出失败 " << failed_count_.load() << std::endl;
+        return exporter_ ? exporter_->Shutdown(timeout) : true;
+    }
+
+    uint64_t ExportedCount() const {
+        return exported_count_.load(std::memory_order_relaxed);
+    }
+
+    uint64_t DroppedCount() const {
+        return dropped_count_.load(std::memory_order_relaxed);
+    }
+
+private:
+    void ExportLoop() {
+        uint64_t reported_dropped = 0;
+        while (true) {
+            uint64_t flush_target;
+            bool stopping;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait_for(lock, options_.flush_interval, [this]() {
+                    return stopping_.load() || flush_requested_ > flush_completed_ ||
+                           queue_.SizeApprox() >= options_.max_export_batch_size;
+                });
+                flush_target = flush_requested_;
+                stopping = stopping_.load();
+            }
+
+            ExportQueued();
+
+            uint64_t dropped = dropped_count_.load(std::memory_order_relaxed);
+            if (dropped != reported_dropped) {
+                std::cerr << "span队列已满，累计丢弃 " << dropped << " 个span" << std::endl;
+                reported_dropped = dropped;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                flush_completed_ = flush_target;
+            }
+            flush_cv_.notify_all();
+
+            if (stopping) {
+                break;
+            }
+        }
+    }
+
+    /**
+     * @brief 按批导出队列中已有的span
+     */
+    void ExportQueued() {
+        std::vector<std::unique_ptr<opentelemetry::sdk::trace::Recordable>> batch;
+        batch.reserve(options_.max_export_batch_size);
+
+        while (true) {
+            std::unique_ptr<opentelemetry::sdk::trace::Recordable> span;
+            while (batch.size() < options_.max_export_batch_size && queue_.TryPop(span)) {
+                batch.push_back(std::move(span));
+            }
+            if (batch.empty()) {
+                return;
+            }
+
+            auto result = exporter_
+                ? exporter_->Export(opentelemetry::nostd::span<std::unique_ptr<opentelemetry::sdk::trace::Recordable>>(
+                      batch.data(), batch.size()))
+                : opentelemetry::sdk::common::ExportResult::kFailure;
+            if (result == opentelemetry::sdk::common::ExportResult::kSuccess) {
+                exported_count_.fetch_add(batch.size(), std::memory_order_relaxed);
+            } else {
+                failed_count_.fetch_add(batch.size(), std::memory_order_relaxed);
+            }
+
+            bool full_batch = batch.size() == options_.max_export_batch_size;
+            batch.clear();
+            if (!full_batch) {
+                return;
+            }
+        }
+    }
+
+    std::unique_ptr<opentelemetry::sdk::trace::SpanExporter> exporter_;
+    BatchSpanOptions options_;
+    BoundedMpmcQueue<std::unique_ptr<opentelemetry::sdk::trace::Recordable>> queue_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;        // 唤醒导出线程
+    std::condition_variable flush_cv_;  // 通知ForceFlush完成
+    std::atomic<bool> stopping_;
+    uint64_t flush_requested_;
+    uint64_t flush_completed_;
+    std::thread worker_;
+
+    std::atomic<uint64_t> exported_count_;
+    std::atomic<uint64_t> dropped_count_;
+    std::atomic<uint64_t> failed_count_;
+};
+
+#endif // BATCH_SPAN_PROCESSOR_H
@@ -0,0 +1,290 @@
+#ifndef BINARY_CODEC_H
+#define BINARY_CODEC_H
+
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+/**
+ * @brief 声明模型字段：同时生成JSON映射和二进制编解码使用的字段列表
+ * 二进制格式不携带字段名，按声明顺序编码，修改字段列表时需要提升编码版本（见tcp_codec.h）
+ */
+#define CHAT_DEFINE_MODEL(Type, ...)                                \
+    NLOHMANN_DEFINE_TYPE_INTRUSIVE(Type, __VA_ARGS__)               \
+    auto BinaryFields() { return std::tie(__VA_ARGS__); }           \
+    auto BinaryFields() const { return std::tie(__VA_ARGS__); }
+
+/**
+ * @brief 同CHAT_DEFINE_MODEL，但JSON中缺少的字段取默认构造对象中的值而不是报错
+ * 用于新增过字段的请求模型，未携带新字段的旧调用方仍能解码；类型必须可默认构造
+ */
+#define CHAT_DEFINE_MODEL_WITH_DEFAULT(Type, ...)                   \
+    NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT(Type, __VA_ARGS__)  \
+    auto BinaryFields() { return std::tie(__VA_ARGS__); }           \
+    auto BinaryFields() const { return std::tie(__VA_ARGS__); }
+
+namespace binary_codec {
+
+/**
+ * @brief 追加写入的输出缓冲
+ */
+class Writer {
+public:
+    explicit Writer(std::vector<uint8_t>& out) : out_(out) {}
+
+    /**
+     * @brief 写入无符号变长整数（每字节7位，高位为续位标志）
+     */
+    void WriteVarint(uint64_t value) {
+        while (value >= 0x80) {
+            out_.push_back(static_cast<uint8_t>(value) | 0x80);
+            value >>= 7;
+        }
+        out_.push_back(static_cast<uint8_t>(value));
+    }
+
+    void WriteByte(uint8_t value) {
+        out_.push_back(value);
+    }
+
+    void WriteBytes(const void* data, size_t size) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        out_.insert(out_.end(), bytes, bytes + size);
+    }
+
+private:
+    std::vector<uint8_t>& out_;
+};
+
+/**
+ * @brief 带边界检查的输入游标，数据被截断或格式非法时抛出异常
+ */
+class Reader {
+public:
+    Reader(const uint8_t* data, size_t size) : data_(data), size_(size), offset_(0) {}
+
+    uint64_t ReadVarint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t byte = ReadByte();
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return value;
+            }
+        }
+        throw std::runtime_error("二进制数据格式错误: 变长整数过长");
+    }
+
+    uint8_t ReadByte() {
+        if (offset_ >= size_) {
+            throw std::runtime_error("二进制数据格式错误: 数据被截断");
+        }
+        return data_[offset_++];
+    }
+
+    const uint8_t* ReadBytes(size_t size) {
+        if (size > Remaining()) {
+            throw std::runtime_error("二进制数据格式错误: 数据被截断");
+        }
+        const uint8_t* bytes = data_ + offset_;
+        offset_ += size;
+        return bytes;
+    }
+
+    size_t Remaining() const {
+        return size_ - offset_;
+    }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    size_t offset_;
+};
+
+/**
+ * @brief 类型是否通过CHAT_DEFINE_MODEL声明了字段列表
+ */
+template<typename T, typename = void>
+struct IsModel : std::false_type {};
+
+template<typename T>
+struct IsModel<T, std::void_t<decltype(std::declval<const T&>().BinaryFields())>> : std::true_type {};
+
+/**
+ * @brief 各类型的编解码规则，未特化的类型在编译期报错
+ */
+template<typename T, typename Enable = void>
+struct ValueCodec;
+
+template<>
+struct ValueCodec<bool> {
+    static void Encode(Writer& writer, bool value) {
+        writer.WriteByte(value ? 1 : 0);
+    }
+
+    static void Decode(Reader& reader, bool& value) {
+        uint8_t byte = reader.ReadByte();
+        if (byte > 1) {
+            throw std::runtime_error("二进制数据格式错误: 非法的布尔值");
+        }
+        value = byte == 1;
+    }
+};
+
+/**
+ * @brief 整数：有符号数先做zigzag变换，使小的负数也只占很少字节
+ */
+template<typename T>
+struct ValueCodec<T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>> {
+    static void Encode(Writer& writer, T value) {
+        if constexpr (std::is_signed_v<T>) {
+            int64_t wide = value;
+            writer.WriteVarint((static_cast<uint64_t>(wide) << 1) ^ static_cast<uint64_t>(wide >> 63));
+        } else {
+            writer.WriteVarint(value);
+        }
+    }
+
+    static void Decode(Reader& reader, T& value) {
+        uint64_t raw = reader.ReadVarint();
+        if constexpr (std::is_signed_v<T>) {
+            int64_t wide = static_cast<int64_t>(raw >> 1) ^ -static_cast<int64_t>(raw & 1);
+            if (wide < std::numeric_limits<T>::min() || wide > std::numeric_limits<T>::max()) {
+                throw std::runtime_error("二进制数据格式错误: 整数超出范围");
+            }
+            value = static_cast<T>(wide);
+        } else {
+            if (raw > std::numeric_limits<T>::max()) {
+                throw std::runtime_error("二进制数据格式错误: 整数超出范围");
+            }
+            value = static_cast<T>(raw);
+        }
+    }
+};
+
+template<>
+struct ValueCodec<std::string> {
+    static void Encode(Writer& writer, const std::string& value) {
+        writer.WriteVarint(value.size());
+        writer.WriteBytes(value.data(), value.size());
+    }
+
+    static void Decode(Reader& reader, std::string& value) {
+        size_t size = ReadSize(reader);
+        value.assign(reinterpret_cast<const char*>(reader.ReadBytes(size)), size);
+    }
+
+    /**
+     * @brief 读取长度前缀；长度不可能超过剩余字节数，提前拒绝以免按伪造的长度分配内存
+     */
+    static size_t ReadSize(Reader& reader) {
+        uint64_t size = reader.ReadVarint();
+        if (size > reader.Remaining()) {
+            throw std::runtime_error("二进制数据格式错误: 长度超出数据范围");
+        }
+        return static_cast<size_t>(size);
+    }
+};
+
+template<typename T>
+struct ValueCodec<std::vector<T>> {
+    static void Encode(Writer& writer, const std::vector<T>& value) {
+        writer.WriteVarint(value.size());
+        for (const auto& element : value) {
+            ValueCodec<T>::Encode(writer, element);
+        }
+    }
+
+    static void Decode(Reader& reader, std::vector<T>& value) {
+        // 每个元素至少占一个字节
+        size_t count = ValueCodec<std::string>::ReadSize(reader);
+        value.clear();
+        value.resize(count);
+        for (auto& element : value) {
+            ValueCodec<T>::Decode(reader, element);
+        }
+    }
+};
+
+template<typename K, typename V>
+struct ValueCodec<std::map<K, V>> {
+    static void Encode(Writer& writer, const std::map<K, V>& value) {
+        writer.WriteVarint(value.size());
+        for (const auto& entry : value) {
+            ValueCodec<K>::Encode(writer, entry.first);
+            ValueCodec<V>::Encode(writer, entry.second);
+        }
+    }
+
+    static void Decode(Reader& reader, std::map<K, V>& value) {
+        size_t count = ValueCodec<std::string>::ReadSize(reader);
+        value.clear();
+        for (size_t i = 0; i < count; ++i) {
+            K key;
+            V mapped;
+            ValueCodec<K>::Decode(reader, key);
+            ValueCodec<V>::Decode(reader, mapped);
+            // 编码端按键有序写出，追加到末尾即可
+            value.emplace_hint(value.end(), std::move(key), std::move(mapped));
+        }
+    }
+};
+
+/**
+ * @brief 模型结构体：按字段声明顺序依次编码，没有字段名和中间DOM
+ */
+template<typename T>
+struct ValueCodec<T, std::enable_if_t<IsModel<T>::value>> {
+    static void Encode(Writer& writer, const T& value) {
+        std::apply([&writer](const auto&... fields) {
+            (ValueCodec<std::decay_t<decltype(fields)>>::Encode(writer, fields), ...);
+        }, value.BinaryFields());
+    }
+
+    static void Decode(Reader& reader, T& value) {
+        std::apply([&reader](auto&... fields) {
+            (ValueCodec<std::decay_t<decltype(fields)>>::Decode(reader, fields), ...);
+        }, value.BinaryFields());
+    }
+};
+
+/**
+ * @brief 把value编码后追加到out末尾
+ */
+template<typename T>
+void EncodeTo(const T& value, std::vector<uint8_t>& out) {
+    Writer writer(out);
+    ValueCodec<T>::Encode(writer, value);
+}
+
+template<typename T>
+std::vector<uint8_t> Encode(const T& value) {
+    std::vector<uint8_t> out;
+    EncodeTo(value, out);
+    return out;
+}
+
+/**
+ * @brief 解码完整的一段数据，末尾有多余字节同样视为格式错误
+ */
+template<typename T>
+T Decode(const uint8_t* data, size_t size) {
+    Reader reader(data, size);
+    T value{};
+    ValueCodec<T>::Decode(reader, value);
+    if (reader.Remaining() != 0) {
+        throw std::runtime_error("二进制数据格式错误: 存在多余数据");
+    }
+    return value;
+}
+
+} // namespace binary_codec
+
+#endif // BINARY_CODEC_H
@@ -0,0 +1,138 @@
+#ifndef ID128_H
+#define ID128_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+#include "random_source.h"
+
+namespace chat {
+
+/**
+ * @brief 128位ID，按UUIDv7布局生成
+ * 高48位为毫秒时间戳，其后是版本号和随机位，按数值比较即按创建时间排序。
+ * 服务内部以16字节的值作为键和索引项，比较只需两次整数比较；
+ * 只在进出模型（JSON/二进制编码）时与"8-4-4-4-12"格式的十六进制字符串互相转换
+ */
+struct Id128 {
+    uint64_t high = 0;
+    uint64_t low = 0;
+
+    /**
+     * @brief 生成新ID，随机位取自线程本地的随机源，无需加锁
+     */
+    static Id128 Generate() {
+        uint64_t millis = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+        RandomSource& random = RandomSource::Local();
+        uint64_t random_a = random.NextU64();
+        uint64_t random_b = random.NextU64();
+
+        Id128 id;
+        id.high = (millis << 16) | 0x7000 | (random_a & 0x0FFF);          // 时间戳48位 | 版本7 | 随机12位
+        id.low = 0x8000000000000000ULL | (random_b & 0x3FFFFFFFFFFFFFFFULL);  // 变体10 | 随机62位
+        return id;
+    }
+
+    /**
+     * @brief 解析"8-4-4-4-12"或不带连字符的32位十六进制字符串（不区分大小写）
+     * @return 格式不正确时返回false，id保持不变
+     */
+    static bool Parse(std::string_view text, Id128& id) {
+        bool dashed = text.size() == 36;
+        if (!dashed && text.size() != 32) {
+            return false;
+        }
+        uint64_t words[2] = {0, 0};
+        int digits = 0;
+        for (size_t i = 0; i < text.size(); ++i) {
+            if (dashed && (i == 8 || i == 13 || i == 18 || i == 23)) {
+                if (text[i] != '-') {
+                    return false;
+                }
+                continue;
+            }
+            int value = HexValue(text[i]);
+            if (value < 0) {
+                return false;
+            }
+            words[digits / 16] = (words[digits / 16] << 4) | static_cast<uint64_t>(value);
+            ++digits;
+        }
+        id.high = words[0];
+        id.low = words[1];
+        return true;
+    }
+
+    /**
+     * @brief 格式化为小写的"8-4-4-4-12"字符串
+     */
+    std::string ToString() const {
+        static const char kDigits[] = "0123456789abcdef";
+        std::string text(36, '-');
+        size_t pos = 0;
+        for (int i = 0; i < 32; ++i) {
+            if (i == 8 || i == 12 || i == 16 || i == 20) {
+                ++pos;
+            }
+            uint64_t word = i < 16 ? high : low;
+            text[pos++] = kDigits[(word >> ((15 - i % 16) * 4)) & 0xF];
+        }
+        return text;
+    }
+
+    /**
+     * @brief 生成时的毫秒时间戳（仅对本类生成的ID有意义）
+     */
+    int64_t Timestamp() const {
+        return static_cast<int64_t>(high >> 16);
+    }
+
+    bool IsNil() const {
+        return high == 0 && low == 0;
+    }
+
+    bool operator==(const Id128& other) const {
+        return high == other.high && low == other.low;
+    }
+
+    bool operator!=(const Id128& other) const {
+        return !(*this == other);
+    }
+
+    bool operator<(const Id128& other) const {
+        return high != other.high ? high < other.high : low < other.low;
+    }
+
+private:
+    static int HexValue(char c) {
+        if (c >= '0' && c <= '9') {
+            return c - '0';
+        }
+        if (c >= 'a' && c <= 'f') {
+            return c - 'a' + 10;
+        }
+        if (c >= 'A' && c <= 'F') {
+            return c - 'A' + 10;
+        }
+        return -1;
+    }
+};
+
+/**
+ * @brief Id128的哈希，用于无序容器和分片
+ */
+struct Id128Hash {
+    size_t operator()(const Id128& id) const {
+        uint64_t mixed = id.high ^ (id.low * 0x9E3779B97F4A7C15ULL);
+        mixed ^= mixed >> 32;
+        return static_cast<size_t>(mixed);
+    }
+};
+
+} // namespace chat
+
+#endif // ID128_H
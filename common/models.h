@@ -6,6 +6,8 @@
 #include <map>
 #include <nlohmann/json.hpp>
 
+#include "binary_codec.h"
+
 namespace chat {
 namespace models {
 
@@ -15,17 +17,17 @@ struct RegisterRequest {
     std::string password;
     std::string email;
     
-    NLOHMANN_DEFINE_TYPE_INTRUSIVE(RegisterRequest, username, password, email)
+    CHAT_DEFINE_MODEL(RegisterRequest, username, password, email)
 };
 
 // 用户注册响应
 struct RegisterResponse {
-    bool success;
+    bool success = false;
     std::string message;
     std::string user_id;
     std::string token;  // 添加token字段
     
-    NLOHMANN_DEFINE_TYPE_INTRUSIVE(RegisterResponse, success, message, user_id, token)
+    CHAT_DEFINE_MODEL(RegisterResponse, success, message, user_id, token)
 };
 
 // 用户登录请求
@@ -33,26 +35,26 @@ struct LoginRequest {
     std::string username;
     std::string password;
     
-    NLOHMANN_DEFINE_TYPE_INTRUSIVE(LoginRequest, username, password)
+    CHAT_DEFINE_MODEL(LoginRequest, username, password)
 };
 
 // 用户登录响应
 struct LoginResponse {
-    bool success;
+    bool success = false;
     std::string message;
     std::string token;
     std::string user_id;
     std::string username;  // 添加username字段
     std::string email;     // 添加email字段
     
-    NLOHMANN_DEFINE_TYPE_INTRUSIVE(LoginResponse, success, message, token, user_id, username, email)
+    CHAT_DEFINE_MODEL(LoginResponse, success, message, token, user_id, username, email)
 };
 
 // 获取用户信息请求
 struct GetUserRequest {
     std::string user_id;
     
-    NLOHMANN_DEFINE_TYPE_INTRUSIVE(GetUserRequest, user_id)
+    CHAT_DEFINE_MODEL(GetUserRequest, user_id)
 };
 
 // 用户信息
@@ -66,7 +68,40 @@ struct UserInfo {
     int64_t created_at;
     int64_t last_active;
     
-    NLOHMANN_DEFINE_TYPE_INTRUSIVE(UserInfo, success, message, user_id, username, email, status, created_at, last_active)
+    CHAT_DEFINE_MODEL(UserInfo, success, message, user_id, username, email, status, created_at, last_active)
+};
+
+// 批量获取用户信息请求
+struct GetUsersRequest {
+    std::vector<std::string> user_ids;
+    
+    CHAT_DEFINE_MODEL(GetUsersRequest, user_ids)
+};
+
+// 批量获取用户信息响应，users与请求的user_ids按顺序一一对应，不存在的用户success为false
+struct GetUsersResponse {
+    bool success = false;
+    std::string message;
+    std::vector<UserInfo> users;
+    
+    CHAT_DEFINE_MODEL(GetUsersResponse, success, message, users)
+};
+
+// 令牌认证请求
+struct AuthRequest {
+    std::string token;
+    
+    CHAT_DEFINE_MODEL(AuthRequest, token)
+};
+
+// 令牌认证响应，令牌无效时success为false
+struct AuthResponse {
+    bool success = false;
+    std::string message;
+    std::string user_id;
+    std::string username;
+    
+    CHAT_DEFINE_MODEL(AuthResponse, success, message, user_id, username)
 };
 
 // 消息发送请求
@@ -76,27 +111,28 @@ struct SendMessageRequest {
     std::string content;
     std::string message_type;
     
-    NLOHMANN_DEFINE_TYPE_INTRUSIVE(SendMessageRequest, sender_id, receiver_id, content, message_type)
+    CHAT_DEFINE_MODEL(SendMessageRequest, sender_id, receiver_id, content, message_type)
 };
 
 // 消息发送响应
 struct SendMessageResponse {
-    bool success;
+    bool success = false;
     std::string message;
     std::string message_id;
     int64_t timestamp;
     
-    NLOHMANN_DEFINE_TYPE_INTRUSIVE(SendMessageResponse, success, message, message_id, timestamp)
+    CHAT_DEFINE_MODEL(SendMessageResponse, success, message, message_id, timestamp)
 };
 
 // 获取消息请求
 struct GetMessagesRequest {
     std::string user_id;
     std::string other_user_id;
-    int32_t limit;
-    int64_t before_timestamp;
+    int32_t limit = 0;             // 最多返回条数，0表示不限
+    int64_t before_timestamp = 0;  // 只返回早于该时间戳的记录，0表示从最新开始
+    std::string before_message_id; // 上一页最后一条消息的ID，与before_timestamp一起作为游标，同一毫秒的消息不会被跳过
     
-    NLOHMANN_DEFINE_TYPE_INTRUSIVE(GetMessagesRequest, user_id, other_user_id, limit, before_timestamp)
+    CHAT_DEFINE_MODEL_WITH_DEFAULT(GetMessagesRequest, user_id, other_user_id, limit, before_timestamp, before_message_id)
 };
 
 // 消息对象
@@ -109,7 +145,7 @@ struct Message {
     bool is_read = false;  // 修改字段名并添加默认值
     int64_t timestamp;
     
-    NLOHMANN_DEFINE_TYPE_INTRUSIVE(Message, message_id, sender_id, receiver_id, content, message_type, is_read, timestamp)
+    CHAT_DEFINE_MODEL(Message, message_id, sender_id, receiver_id, content, message_type, is_read, timestamp)
 };
 
 // 获取消息响应
@@ -117,10 +153,10 @@ struct GetMessagesResponse {
     bool success = true;     // 添加success字段
     std::string message;     // 添加message字段
     std::vector<Message> messages;
-    bool has_more;
+    bool has_more = false;
     int total_count = 0;     // 添加total_count字段
     
-    NLOHMANN_DEFINE_TYPE_INTRUSIVE(GetMessagesResponse, success, message, messages, has_more, total_count)
+    CHAT_DEFINE_MODEL(GetMessagesResponse, success, message, messages, has_more, total_count)
 };
 
 // 标记消息已读请求
@@ -128,15 +164,40 @@ struct MarkMessageReadRequest {
     std::string user_id;
     std::string message_id;
     
-    NLOHMANN_DEFINE_TYPE_INTRUSIVE(MarkMessageReadRequest, user_id, message_id)
+    CHAT_DEFINE_MODEL(MarkMessageReadRequest, user_id, message_id)
 };
 
 // 标记消息已读响应
 struct MarkMessageReadResponse {
-    bool success;
+    bool success = false;
     std::string message;  // 添加message字段
     
-    NLOHMANN_DEFINE_TYPE_INTRUSIVE(MarkMessageReadResponse, success, message)
+    CHAT_DEFINE_MODEL(MarkMessageReadResponse, success, message)
+};
+
+// 获取未读消息数请求
+struct GetUnreadCountsRequest {
+    std::string user_id;
+    
+    CHAT_DEFINE_MODEL(GetUnreadCountsRequest, user_id)
+};
+
+// 与某个用户的会话中的未读消息数
+struct ConversationUnread {
+    std::string other_user_id;
+    int64_t unread_count = 0;
+    
+    CHAT_DEFINE_MODEL(ConversationUnread, other_user_id, unread_count)
+};
+
+// 获取未读消息数响应，conversations只包含有未读消息的会话
+struct GetUnreadCountsResponse {
+    bool success = false;
+    std::string message;
+    int64_t total_unread = 0;
+    std::vector<ConversationUnread> conversations;
+    
+    CHAT_DEFINE_MODEL(GetUnreadCountsResponse, success, message, total_unread, conversations)
 };
 
 // 通知请求
@@ -147,26 +208,66 @@ struct NotificationRequest {
     std::string type;  // 修改字段名为type
     std::map<std::string, std::string> metadata;
     
-    NLOHMANN_DEFINE_TYPE_INTRUSIVE(NotificationRequest, user_id, title, content, type, metadata)
+    CHAT_DEFINE_MODEL(NotificationRequest, user_id, title, content, type, metadata)
 };
 
 // 通知响应
 struct NotificationResponse {
-    bool success;
+    bool success = false;
     std::string message;          // 添加message字段
     std::string notification_id;
     int64_t timestamp;           // 添加timestamp字段
     
-    NLOHMANN_DEFINE_TYPE_INTRUSIVE(NotificationResponse, success, message, notification_id, timestamp)
+    CHAT_DEFINE_MODEL(NotificationResponse, success, message, notification_id, timestamp)
+};
+
+// 批量通知请求：同一条通知发给多个用户
+struct BulkNotificationRequest {
+    std::vector<std::string> user_ids;
+    std::string title;
+    std::string content;
+    std::string type;
+    std::map<std::string, std::string> metadata;
+    
+    CHAT_DEFINE_MODEL(BulkNotificationRequest, user_ids, title, content, type, metadata)
+};
+
+// 批量通知响应：重复的用户ID只发送一次，不存在的用户列在failed_user_ids中
+struct BulkNotificationResponse {
+    bool success = false;
+    std::string message;
+    int64_t timestamp = 0;
+    int32_t delivered_count = 0;
+    std::vector<std::string> failed_user_ids;
+    
+    CHAT_DEFINE_MODEL(BulkNotificationResponse, success, message, timestamp, delivered_count, failed_user_ids)
+};
+
+// 通知批量请求：一次提交多条各自独立的通知（收件人、内容可以不同）
+struct NotificationBatchRequest {
+    std::vector<NotificationRequest> notifications;
+    
+    CHAT_DEFINE_MODEL(NotificationBatchRequest, notifications)
+};
+
+// 通知批量响应，收件人不存在的通知计入failed_count
+struct NotificationBatchResponse {
+    bool success = false;
+    std::string message;
+    int32_t delivered_count = 0;
+    int32_t failed_count = 0;
+    
+    CHAT_DEFINE_MODEL(NotificationBatchResponse, success, message, delivered_count, failed_count)
 };
 
 // 获取通知列表请求
 struct GetNotificationsRequest {
     std::string user_id;
-    int32_t limit;
-    int64_t before_timestamp;
+    int32_t limit = 0;             // 最多返回条数，0表示不限
+    int64_t before_timestamp = 0;  // 只返回早于该时间戳的记录，0表示从最新开始
+    int64_t before_sequence = 0;   // 上一页最后一条通知的序号，与before_timestamp一起作为游标，同一毫秒的通知不会被跳过
     
-    NLOHMANN_DEFINE_TYPE_INTRUSIVE(GetNotificationsRequest, user_id, limit, before_timestamp)
+    CHAT_DEFINE_MODEL_WITH_DEFAULT(GetNotificationsRequest, user_id, limit, before_timestamp, before_sequence)
 };
 
 // 通知对象
@@ -177,10 +278,12 @@ struct Notification {
     std::string content;
     std::string type;        // 修改字段名为type
     bool is_read = false;    // 修改字段名为is_read并添加默认值
-    int64_t timestamp;
+    int64_t timestamp = 0;
     std::map<std::string, std::string> metadata;
+    int64_t sequence = 0;    // 在该用户通知中的序号，用作分页和订阅的游标
     
-    NLOHMANN_DEFINE_TYPE_INTRUSIVE(Notification, notification_id, user_id, title, content, type, is_read, timestamp, metadata)
+    CHAT_DEFINE_MODEL_WITH_DEFAULT(Notification, notification_id, user_id, title, content, type, is_read, timestamp,
+                                   metadata, sequence)
 };
 
 // 获取通知列表响应
@@ -188,10 +291,31 @@ struct GetNotificationsResponse {
     bool success = true;     // 添加success字段
     std::string message;     // 添加message字段
     std::vector<Notification> notifications;
-    bool has_more;
+    bool has_more = false;
     int total_count = 0;     // 添加total_count字段
     
-    NLOHMANN_DEFINE_TYPE_INTRUSIVE(GetNotificationsResponse, success, message, notifications, has_more, total_count)
+    CHAT_DEFINE_MODEL(GetNotificationsResponse, success, message, notifications, has_more, total_count)
+};
+
+// 订阅通知请求（长轮询）：有序号大于cursor的通知时立即返回，否则最多等待wait_ms
+struct SubscribeNotificationsRequest {
+    std::string user_id;
+    int64_t cursor = -1;    // 已收到的最后一条通知的序号，<0表示只接收此后的新通知
+    int32_t limit = 0;      // 最多返回条数，0表示不限
+    int32_t wait_ms = 0;    // 没有新通知时的最长等待时间，0表示不等待；服务端有上限
+    
+    CHAT_DEFINE_MODEL(SubscribeNotificationsRequest, user_id, cursor, limit, wait_ms)
+};
+
+// 订阅通知响应：notifications按序号从早到晚连续排列，最后一条的序号为cursor
+struct SubscribeNotificationsResponse {
+    bool success = false;
+    std::string message;
+    std::vector<Notification> notifications;
+    int64_t cursor = 0;      // 下次订阅时传入的游标
+    bool has_more = false;   // 是否还有未返回的新通知，有则应立即再次订阅
+    
+    CHAT_DEFINE_MODEL(SubscribeNotificationsResponse, success, message, notifications, cursor, has_more)
 };
 
 } // namespace models
@@ -0,0 +1,107 @@
+#ifndef RANDOM_SOURCE_H
+#define RANDOM_SOURCE_H
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <sys/random.h>
+
+namespace chat {
+
+/**
+ * @brief 每线程独立的随机字节源
+ * 从内核CSPRNG（getrandom）批量读取到线程本地缓冲区，逐段取用：
+ * 生成ID或令牌时既不加锁也不逐次进入内核，缓冲区耗尽时才再读一批。
+ * 输出直接来自内核随机数，可用于认证令牌
+ */
+class RandomSource {
+public:
+    /**
+     * @brief 当前线程的随机源
+     */
+    static RandomSource& Local() {
+        thread_local RandomSource source;
+        return source;
+    }
+
+    /**
+     * @brief 填充size字节随机数
+     * @throws std::runtime_error 内核随机数不可用
+     */
+    void Fill(void* out, size_t size) {
+        uint8_t* dest = static_cast<uint8_t*>(out);
+        while (size > 0) {
+            if (position_ == kBufferSize) {
+                Refill();
+            }
+            size_t n = std::min(size, kBufferSize - position_);
+            std::memcpy(dest, buffer_ + position_, n);
+            position_ += n;
+            dest += n;
+            size -= n;
+        }
+    }
+
+    uint64_t NextU64() {
+        uint64_t value;
+        Fill(&value, sizeof(value));
+        return value;
+    }
+
+    uint8_t NextByte() {
+        if (position_ == kBufferSize) {
+            Refill();
+        }
+        return buffer_[position_++];
+    }
+
+private:
+    static constexpr size_t kBufferSize = 4096;
+
+    RandomSource() : position_(kBufferSize) {}
+
+    RandomSource(const RandomSource&) = delete;
+    RandomSource& operator=(const RandomSource&) = delete;
+
+    void Refill() {
+        size_t filled = 0;
+        while (filled < kBufferSize) {
+            ssize_t n = getrandom(buffer_ + filled, kBufferSize - filled, 0);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error(std::string("读取系统随机数失败: ") + std::strerror(errno));
+            }
+            filled += static_cast<size_t>(n);
+        }
+        position_ = 0;
+    }
+
+    uint8_t buffer_[kBufferSize];
+    size_t position_;
+};
+
+/**
+ * @brief 生成由[0-9A-Za-z]组成的随机令牌，一次遍历直接写入结果
+ * 随机字节按拒绝采样映射到62个字符（丢弃>=248的字节），字符分布均匀
+ */
+inline std::string GenerateToken(size_t length = 32) {
+    static const char kAlphabet[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+    RandomSource& random = RandomSource::Local();
+    std::string token(length, '0');
+    for (size_t i = 0; i < length;) {
+        uint8_t byte = random.NextByte();
+        if (byte < 248) {
+            token[i++] = kAlphabet[byte % 62];
+        }
+    }
+    return token;
+}
+
+} // namespace chat
+
+#endif // RANDOM_SOURCE_H
@@ -0,0 +1,197 @@
+#ifndef TCP_CLIENT_H
+#define TCP_CLIENT_H
+
+#include <cerrno>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+
+#include "tcp_codec.h"
+#include "tcp_connection_pool.h"
+#include "tcp_context_propagation.h"
+#include "tcp_frame.h"
+#include "tcp_io.h"
+#include "tcp_opcodes.h"
+
+namespace tcp_client {
+
+/**
+ * @brief 连接级错误
+ * retryable表示换新连接重试是安全的：请求确定没有完整发出，或请求是幂等的
+ */
+class TcpConnectionError : public std::runtime_error {
+public:
+    TcpConnectionError(const std::string& message, bool retryable)
+        : std::runtime_error(message), retryable_(retryable) {}
+
+    bool Retryable() const {
+        return retryable_;
+    }
+
+private:
+    bool retryable_;
+};
+
+/**
+ * @brief 重复执行不会产生额外效果的消息类型
+ * 请求已发出但没有收到任何响应时，无法判断服务端是否已处理，只有这些请求可以自动重试
+ */
+inline bool IsIdempotent(const std::string& message_type) {
+    static const std::unordered_set<std::string> kIdempotent = {
+        "codec.negotiate",
+        "user.get",
+        "user.get_many",
+        "user.auth",
+        "message.get",
+        "message.mark_read",
+        "message.unread_counts",
+        "notification.get",
+        "notification.subscribe",
+    };
+    return kIdempotent.count(message_type) != 0;
+}
+
+/**
+ * @brief 到某个TCP服务的阻塞式长连接
+ * 每个请求都带上保持连接标志，服务端应答后不会关闭连接；建立连接后先协商请求体编码。
+ * 请求帧的各片段一次sendmsg写出，响应经缓冲读取，一次RPC通常只有一次发送和一次接收
+ */
+class TcpClientConnection {
+public:
+    /**
+     * @brief 建立连接
+     */
+    TcpClientConnection(const std::string& host, int port)
+        : socket_(tcp_io::Connect(host, port)), reader_(socket_) {
+        try {
+            features_ = tcp_codec::ParseNegotiateResponse(
+                Call(tcp_codec::kNegotiateMessageType, tcp_codec::MakeNegotiateRequest(), false));
+        } catch (const TcpConnectionError&) {
+            close(socket_);
+            throw std::runtime_error("协商编码失败");
+        }
+    }
+
+    ~TcpClientConnection() {
+        close(socket_);
+    }
+
+    TcpClientConnection(const TcpClientConnection&) = delete;
+    TcpClientConnection& operator=(const TcpClientConnection&) = delete;
+
+    /**
+     * @brief 发送一个请求并等待响应
+     * @param binary 请求体是否为二进制编码（仅在协商成功的连接上使用）
+     * @throws TcpConnectionError 连接异常，此后该连接不可再用
+     */
+    std::vector<uint8_t> Call(const std::string& message_type, const std::vector<uint8_t>& request_data,
+                              bool binary) {
+        // 获取当前追踪上下文
+        auto trace_data = tcp_context_propagation::GetCurrentTraceContextBinary();
+        uint8_t flags = tcp_frame::kFlagKeepAlive | (binary ? tcp_frame::kFlagBinaryCodec : 0);
+        uint16_t opcode = features_.opcodes ? tcp_opcode::FindOpcode(message_type) : tcp_opcode::kInvalidOpcode;
+        tcp_frame::RequestSegments segments(flags, trace_data, message_type, request_data, 0, opcode);
+
+        if (!tcp_io::SendAll(socket_, segments.Iov(), segments.Count())) {
+            throw TcpConnectionError("发送请求失败", true);
+        }
+
+        // 接收响应大小
+        uint32_t response_size = 0;
+        size_t received = 0;
+        if (!reader_.ReadExact(&response_size, 4, received)) {
+            // 请求已完整发出，服务端可能已处理后才断开，非幂等请求不能重试
+            throw TcpConnectionError("接收响应失败", received == 0 && IsIdempotent(message_type));
+        }
+        response_size = ntohl(response_size);
+
+        // 接收响应数据（通常已随响应大小一起读入缓冲区）
+        std::vector<uint8_t> response_data(response_size);
+        received = 0;
+        if (!reader_.ReadExact(response_data.data(), response_size, received)) {
+            throw TcpConnectionError("接收响应失败", false);
+        }
+
+        return response_data;
+    }
+
+    /**
+     * @brief 该连接是否协商使用二进制编码
+     */
+    bool BinaryCodec() const {
+        return features_.binary_codec;
+    }
+
+    /**
+     * @brief 空闲连接的健康检查：对端已关闭或收到了不属于任何请求的数据都视为不健康
+     */
+    bool IsHealthy() const {
+        if (reader_.Buffered() > 0) {
+            return false;
+        }
+        uint8_t probe;
+        ssize_t n = recv(socket_, &probe, 1, MSG_PEEK | MSG_DONTWAIT);
+        return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+
+private:
+    int socket_;
+    tcp_io::BufferedReader reader_;
+    tcp_codec::NegotiatedFeatures features_;
+};
+
+using ConnectionPoolRegistry = TcpConnectionPoolRegistry<TcpClientConnection>;
+
+/**
+ * @brief 从对应后端的连接池借出连接执行一次请求
+ * exchange在借出的连接上完成编码、收发与解码，因此可以按该连接协商的编码序列化
+ */
+template<typename Exchange>
+auto Call(const std::string& host, int port, Exchange&& exchange)
+    -> decltype(exchange(std::declval<TcpClientConnection&>())) {
+    auto& pool = ConnectionPoolRegistry::Instance().GetPool(host, port);
+
+    auto lease = pool.Acquire();
+    try {
+        return exchange(*lease);
+    } catch (const TcpConnectionError& e) {
+        // 连接已失效，不再归还；复用的连接在重试安全时（请求未发出或幂等）换新连接重试一次
+        lease.Discard();
+        if (!lease.Reused() || !e.Retryable()) {
+            throw;
+        }
+    }
+
+    auto fresh = pool.AcquireFresh();
+    try {
+        return exchange(*fresh);
+    } catch (const TcpConnectionError&) {
+        fresh.Discard();
+        throw;
+    }
+}
+
+/**
+ * @brief 发送TCP请求到其他服务
+ * 消息格式: [flags|trace_data_size(4)][trace_data][msg_type_size(4)][msg_type][data_size(4)][data]
+ */
+template<typename RequestType, typename ResponseType>
+ResponseType SendRequest(const std::string& host, int port,
+                         const std::string& message_type,
+                         const RequestType& request) {
+    return Call(host, port, [&](TcpClientConnection& connection) {
+        bool binary = connection.BinaryCodec();
+        auto response_data = connection.Call(message_type, tcp_codec::EncodeRequest(request, binary), binary);
+        return tcp_codec::DecodeResponse<ResponseType>(response_data, binary);
+    });
+}
+
+} // namespace tcp_client
+
+#endif // TCP_CLIENT_H
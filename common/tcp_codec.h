@@ -0,0 +1,132 @@
+#ifndef TCP_CODEC_H
+#define TCP_CODEC_H
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+#include "binary_codec.h"
+
+/**
+ * @brief TCP请求/响应体的编码协商与编解码
+ * 客户端每建立一条连接先发送一次codec.negotiate（JSON），服务端支持时该连接后续请求都带
+ * kFlagBinaryCodec并使用二进制编码，同时协商是否以操作码代替消息类型字符串；
+ * 旧服务端会返回"未知消息类型"，客户端随即回退到JSON。
+ * 带kFlagBinaryCodec的请求，其响应体首字节标记编码：错误响应等仍可能是JSON
+ */
+namespace tcp_codec {
+
+constexpr const char* kNegotiateMessageType = "codec.negotiate";
+
+/**
+ * @brief 二进制编码名称，字段布局变化时提升版本号，新旧进程会自动协商回JSON
+ */
+constexpr const char* kBinaryCodecName = "binary.v1";
+constexpr const char* kJsonCodecName = "json";
+
+/**
+ * @brief 响应体编码标记
+ */
+constexpr uint8_t kPayloadJson = 0;
+constexpr uint8_t kPayloadBinary = 1;
+
+// 编码协商请求
+struct NegotiateRequest {
+    std::vector<std::string> codecs;  // 客户端支持的编码，按偏好排序
+
+    CHAT_DEFINE_MODEL(NegotiateRequest, codecs)
+};
+
+// 编码协商响应
+struct NegotiateResponse {
+    bool success = true;
+    std::string message;
+    std::string codec;     // 服务端选定的编码
+    bool opcodes = false;  // 服务端是否接受以操作码代替消息类型字符串
+
+    CHAT_DEFINE_MODEL(NegotiateResponse, success, message, codec, opcodes)
+};
+
+/**
+ * @brief 服务端选择编码：客户端列出了二进制编码则使用之，否则使用JSON
+ */
+inline NegotiateResponse Negotiate(const NegotiateRequest& request) {
+    NegotiateResponse response;
+    bool binary = std::find(request.codecs.begin(), request.codecs.end(),
+                            kBinaryCodecName) != request.codecs.end();
+    response.codec = binary ? kBinaryCodecName : kJsonCodecName;
+    response.opcodes = true;
+    return response;
+}
+
+/**
+ * @brief 构造客户端的协商请求体
+ */
+inline std::vector<uint8_t> MakeNegotiateRequest() {
+    nlohmann::json json_request = NegotiateRequest{{kBinaryCodecName, kJsonCodecName}};
+    auto request_str = json_request.dump();
+    return std::vector<uint8_t>(request_str.begin(), request_str.end());
+}
+
+/**
+ * @brief 连接协商的结果
+ */
+struct NegotiatedFeatures {
+    bool binary_codec = false;
+    bool opcodes = false;
+};
+
+/**
+ * @brief 解析协商响应；旧服务端的错误响应或缺失的字段都按不支持处理
+ */
+inline NegotiatedFeatures ParseNegotiateResponse(const std::vector<uint8_t>& response_data) {
+    NegotiatedFeatures features;
+    auto json_data = nlohmann::json::parse(response_data.begin(), response_data.end(), nullptr, false);
+    if (!json_data.is_object() || !json_data.value("success", false)) {
+        return features;
+    }
+    features.binary_codec = json_data.value("codec", std::string(kJsonCodecName)) == kBinaryCodecName;
+    features.opcodes = json_data.value("opcodes", false);
+    return features;
+}
+
+/**
+ * @brief 按连接协商的编码序列化请求体
+ */
+template<typename RequestType>
+std::vector<uint8_t> EncodeRequest(const RequestType& request, bool binary) {
+    if (binary) {
+        return binary_codec::Encode(request);
+    }
+    nlohmann::json json_request = request;
+    auto request_str = json_request.dump();
+    return std::vector<uint8_t>(request_str.begin(), request_str.end());
+}
+
+/**
+ * @brief 反序列化响应体；二进制请求的响应先读取编码标记
+ */
+template<typename ResponseType>
+ResponseType DecodeResponse(const std::vector<uint8_t>& response_data, bool binary) {
+    const uint8_t* data = response_data.data();
+    size_t size = response_data.size();
+    if (binary) {
+        if (size == 0) {
+            throw std::runtime_error("响应数据为空");
+        }
+        uint8_t tag = data[0];
+        if (tag == kPayloadBinary) {
+            return binary_codec::Decode<ResponseType>(data + 1, size - 1);
+        }
+        ++data;
+        --size;
+    }
+    auto json_data = nlohmann::json::parse(data, data + size);
+    return json_data.get<ResponseType>();
+}
+
+} // namespace tcp_codec
+
+#endif // TCP_CODEC_H
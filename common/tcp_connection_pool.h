@@ -0,0 +1,303 @@
+#ifndef TCP_CONNECTION_POOL_H
+#define TCP_CONNECTION_POOL_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tcp_client {
+
+/**
+ * @brief 连接池参数
+ */
+struct TcpConnectionPoolOptions {
+    size_t min_idle = 2;                                  // 维护线程预热并保持的最少空闲连接
+    size_t max_idle = 64;                                 // 归还时超过该数量的连接直接关闭
+    std::chrono::milliseconds idle_timeout{60000};        // 空闲超过该时长的连接被回收（保留min_idle个）
+    std::chrono::milliseconds maintenance_interval{1000}; // 维护线程的巡检周期
+};
+
+/**
+ * @brief 单个后端地址的连接池
+ * 空闲连接按线程分片存放，线程优先从自己的分片取还，分片为空时再从其他分片借用，
+ * 因此常态下不同线程之间没有锁竞争
+ */
+template<typename Connection>
+class TcpConnectionPool {
+public:
+    using Factory = std::function<std::unique_ptr<Connection>()>;
+
+    TcpConnectionPool(Factory factory, const TcpConnectionPoolOptions& options)
+        : factory_(std::move(factory)), options_(options), shards_(ShardCount()), idle_count_(0) {
+    }
+
+    TcpConnectionPool(const TcpConnectionPool&) = delete;
+    TcpConnectionPool& operator=(const TcpConnectionPool&) = delete;
+
+    /**
+     * @brief 借出的连接，析构时自动归还；调用Discard()后析构时关闭连接
+     */
+    class Lease {
+    public:
+        Lease(TcpConnectionPool* pool, std::unique_ptr<Connection> connection, bool reused)
+            : pool_(pool), connection_(std::move(connection)), reused_(reused) {}
+
+        Lease(Lease&& other) noexcept = default;
+        Lease& operator=(Lease&&) = delete;
+
+        ~Lease() {
+            if (connection_ && !discarded_) {
+                pool_->Release(std::move(connection_));
+            }
+        }
+
+        Connection* operator->() const {
+            return connection_.get();
+        }
+
+        Connection& operator*() const {
+            return *connection_;
+        }
+
+        /**
+         * @brief 连接来自空闲池（而非刚刚建立）
+         */
+        bool Reused() const {
+            return reused_;
+        }
+
+        /**
+         * @brief 标记连接已损坏，不再归还
+         */
+        void Discard() {
+            discarded_ = true;
+        }
+
+    private:
+        TcpConnectionPool* pool_;
+        std::unique_ptr<Connection> connection_;
+        bool reused_;
+        bool discarded_ = false;
+    };
+
+    /**
+     * @brief 借出最近归还的空闲连接，没有空闲连接时新建
+     * 借出时不做探测：失效的空闲连接由维护线程淘汰，两次巡检之间失效的由调用方换新连接重试一次
+     */
+    Lease Acquire() {
+        size_t home = HomeShard();
+        for (size_t i = 0; i < shards_.size(); ++i) {
+            auto connection = Pop(shards_[(home + i) % shards_.size()]);
+            if (connection) {
+                return Lease(this, std::move(connection), true);
+            }
+        }
+        return Lease(this, factory_(), false);
+    }
+
+    /**
+     * @brief 新建一个不经过空闲池的连接（用于复用连接失效后的重试）
+     */
+    Lease AcquireFresh() {
+        return Lease(this, factory_(), false);
+    }
+
+    /**
+     * @brief 回收超时或已损坏的空闲连接，并把空闲连接补足到min_idle
+     * 探测在分片锁外进行：先取出分片中的全部空闲连接，检查完再把仍可用的放回栈底
+     */
+    void Maintain() {
+        auto now = std::chrono::steady_clock::now();
+        size_t total_idle = idle_count_.load();
+
+        for (auto& shard : shards_) {
+            std::vector<IdleConnection> idle;
+            {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                idle.swap(shard.idle);
+            }
+            if (idle.empty()) {
+                continue;
+            }
+
+            std::vector<IdleConnection> kept;
+            std::vector<std::unique_ptr<Connection>> expired;
+            for (auto& entry : idle) {
+                // 从最久未使用的连接开始；已损坏的连接无论是否超时都淘汰
+                bool timed_out = now - entry.last_used >= options_.idle_timeout &&
+                                 total_idle > options_.min_idle;
+                if (timed_out || !entry.connection->IsHealthy()) {
+                    expired.push_back(std::move(entry.connection));
+                    --total_idle;
+                    --idle_count_;
+                } else {
+                    kept.push_back(std::move(entry));
+                }
+            }
+
+            // 检查期间归还的连接更新，保持在栈顶
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            kept.insert(kept.end(), std::make_move_iterator(shard.idle.begin()),
+                        std::make_move_iterator(shard.idle.end()));
+            shard.idle.swap(kept);
+        }
+
+        while (idle_count_.load() < options_.min_idle) {
+            try {
+                Release(factory_());
+            } catch (const std::exception&) {
+                // 后端暂时不可用，等下一个周期再预热
+                break;
+            }
+        }
+    }
+
+    /**
+     * @brief 当前空闲连接数
+     */
+    size_t IdleCount() const {
+        return idle_count_.load();
+    }
+
+private:
+    struct IdleConnection {
+        std::unique_ptr<Connection> connection;
+        std::chrono::steady_clock::time_point last_used;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::vector<IdleConnection> idle;   // LIFO：最近归还的连接在末尾
+    };
+
+    static size_t ShardCount() {
+        size_t num_shards = std::thread::hardware_concurrency();
+        if (num_shards == 0) num_shards = 1;
+        if (num_shards > 16) num_shards = 16;
+        return num_shards;
+    }
+
+    size_t HomeShard() const {
+        return std::hash<std::thread::id>{}(std::this_thread::get_id()) % shards_.size();
+    }
+
+    /**
+     * @brief 从分片取出最近使用的连接
+     */
+    std::unique_ptr<Connection> Pop(Shard& shard) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (shard.idle.empty()) {
+            return nullptr;
+        }
+        auto connection = std::move(shard.idle.back().connection);
+        shard.idle.pop_back();
+        --idle_count_;
+        return connection;
+    }
+
+    void Release(std::unique_ptr<Connection> connection) {
+        if (idle_count_.load() >= options_.max_idle) {
+            return;
+        }
+        Shard& shard = shards_[HomeShard()];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.idle.push_back({std::move(connection), std::chrono::steady_clock::now()});
+        ++idle_count_;
+    }
+
+    Factory factory_;
+    TcpConnectionPoolOptions options_;
+    std::vector<Shard> shards_;
+    std::atomic<size_t> idle_count_;
+};
+
+/**
+ * @brief 进程内所有后端地址的连接池注册表
+ * 网关与各后端服务共用，后台线程定期维护所有连接池
+ */
+template<typename Connection>
+class TcpConnectionPoolRegistry {
+public:
+    using Pool = TcpConnectionPool<Connection>;
+
+    /**
+     * @brief 进程级单例，故意不析构，避免退出时与维护线程竞争
+     */
+    static TcpConnectionPoolRegistry& Instance() {
+        static auto* registry = new TcpConnectionPoolRegistry();
+        return *registry;
+    }
+
+    /**
+     * @brief 设置之后新建连接池使用的参数
+     */
+    void SetOptions(const TcpConnectionPoolOptions& options) {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        options_ = options;
+    }
+
+    /**
+     * @brief 获取（必要时创建）某个地址的连接池
+     */
+    Pool& GetPool(const std::string& host, int port) {
+        std::string endpoint = host + ":" + std::to_string(port);
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            auto it = pools_.find(endpoint);
+            if (it != pools_.end()) {
+                return *it->second;
+            }
+        }
+
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        auto& pool = pools_[endpoint];
+        if (!pool) {
+            pool = std::make_unique<Pool>([host, port]() {
+                return std::make_unique<Connection>(host, port);
+            }, options_);
+        }
+        if (!maintenance_thread_started_) {
+            maintenance_thread_started_ = true;
+            std::thread([this]() { MaintenanceLoop(); }).detach();
+        }
+        return *pool;
+    }
+
+private:
+    TcpConnectionPoolRegistry() = default;
+
+    void MaintenanceLoop() {
+        while (true) {
+            std::chrono::milliseconds interval;
+            std::vector<Pool*> pools;
+            {
+                std::shared_lock<std::shared_mutex> lock(mutex_);
+                interval = options_.maintenance_interval;
+                for (auto& entry : pools_) {
+                    pools.push_back(entry.second.get());
+                }
+            }
+            for (auto* pool : pools) {
+                pool->Maintain();
+            }
+            std::this_thread::sleep_for(interval);
+        }
+    }
+
+    std::shared_mutex mutex_;
+    TcpConnectionPoolOptions options_;
+    std::map<std::string, std::unique_ptr<Pool>> pools_;
+    bool maintenance_thread_started_ = false;
+};
+
+} // namespace tcp_client
+
+#endif // TCP_CONNECTION_POOL_H
@@ -5,6 +5,7 @@
 #include <vector>
 #include <sstream>
 #include <iomanip>
+#include "opentelemetry/trace/default_span.h"
 #include "opentelemetry/trace/span.h"
 #include "opentelemetry/trace/span_context.h"
 #include "opentelemetry/context/runtime_context.h"
@@ -193,10 +194,8 @@ public:
             true  // is_remote
         );
         
-        // 创建远程span并设置为当前上下文
-        auto tracer = Telemetry::GetTracer();
-        auto remote_span = tracer->StartSpan("remote_operation", 
-            trace::StartSpanOptions{.parent = remote_span_context});
+        // 用不记录、不导出的DefaultSpan承载远程父上下文，服务端span直接挂在调用方span下
+        nostd::shared_ptr<trace::Span> remote_span(new trace::DefaultSpan(remote_span_context));
         
         // 将span设置到当前上下文
         auto current_ctx = context::RuntimeContext::GetCurrent();
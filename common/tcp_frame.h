@@ -0,0 +1,293 @@
+#ifndef TCP_FRAME_H
+#define TCP_FRAME_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sys/uio.h>
+#include <arpa/inet.h>
+
+namespace tcp_frame {
+
+/**
+ * @brief 单个长度字段允许的最大值，防止恶意或损坏的长度导致内存暴涨
+ */
+constexpr uint32_t kDefaultMaxFieldSize = 16 * 1024 * 1024;
+
+/**
+ * @brief 第一个长度字段的高8位用作帧标志，低24位为追踪数据长度
+ * 旧客户端发送的追踪数据长度只有0或31，高8位恒为0，因此保持兼容
+ */
+constexpr uint32_t kFrameFlagsShift = 24;
+constexpr uint32_t kTraceSizeMask = 0x00FFFFFF;
+
+/**
+ * @brief 帧标志位
+ */
+constexpr uint8_t kFlagKeepAlive = 0x01;  // 响应后保持连接，客户端会继续在该连接上发送请求
+constexpr uint8_t kFlagRequestId = 0x02;  // 首字段后紧跟4字节请求ID，服务端可乱序应答，响应带回同一ID
+constexpr uint8_t kFlagBinaryCodec = 0x04;  // 请求体为二进制编码，响应体首字节标记其编码（见tcp_codec.h）
+constexpr uint8_t kFlagOpcode = 0x08;  // 消息类型长度字段改为携带数值操作码，其后不跟类型字符串（见tcp_opcodes.h）
+
+/**
+ * @brief 一个完整的TCP请求帧
+ * 线上格式: [flags(1)|trace_data_size(3)][request_id(4，可选)][trace_data][msg_type_size(4)][msg_type][data_size(4)][data]
+ * 带kFlagOpcode时msg_type_size位置为操作码且没有msg_type
+ */
+struct TcpFrame {
+    uint8_t flags = 0;
+    uint32_t request_id = 0;
+    std::vector<uint8_t> trace_data;
+    uint16_t opcode = 0;        // 仅在带kFlagOpcode时有效
+    std::string message_type;   // 带kFlagOpcode时为空
+    std::vector<uint8_t> payload;
+};
+
+/**
+ * @brief 增量式帧解析器
+ * 非阻塞读取得到的任意字节片段都可以追加进来，解析器只在帧完整时才产出
+ */
+class TcpFrameParser {
+public:
+    enum class Result {
+        kFrame,     // 解析出一个完整帧
+        kNeedMore,  // 数据不足，等待更多字节
+        kError      // 帧格式非法（长度超限），连接应被关闭
+    };
+
+    explicit TcpFrameParser(uint32_t max_field_size = kDefaultMaxFieldSize)
+        : max_field_size_(max_field_size) {}
+
+    /**
+     * @brief 追加从socket读到的原始字节
+     */
+    void Append(const uint8_t* data, size_t size) {
+        buffer_.insert(buffer_.end(), data, data + size);
+    }
+
+    /**
+     * @brief 尝试从缓冲区取出下一个完整帧
+     */
+    Result Next(TcpFrame& frame) {
+        const uint8_t* base = buffer_.data() + read_offset_;
+        size_t available = buffer_.size() - read_offset_;
+        size_t offset = 0;
+
+        uint32_t first_word = 0;
+        if (!ReadLength(base, available, offset, first_word)) return Result::kNeedMore;
+        uint8_t flags = static_cast<uint8_t>(first_word >> kFrameFlagsShift);
+        uint32_t request_id = 0;
+        if ((flags & kFlagRequestId) && !ReadLength(base, available, offset, request_id)) {
+            return Result::kNeedMore;
+        }
+        uint32_t trace_size = first_word & kTraceSizeMask;
+        if (trace_size > max_field_size_) return Result::kError;
+        if (available - offset < trace_size) return Result::kNeedMore;
+        size_t trace_offset = offset;
+        offset += trace_size;
+
+        uint32_t type_size = 0;
+        if (!ReadLength(base, available, offset, type_size)) return Result::kNeedMore;
+        uint32_t opcode = 0;
+        if (flags & kFlagOpcode) {
+            if (type_size > 0xFFFF) return Result::kError;
+            opcode = type_size;
+            type_size = 0;
+        }
+        if (type_size > max_field_size_) return Result::kError;
+        if (available - offset < type_size) return Result::kNeedMore;
+        size_t type_offset = offset;
+        offset += type_size;
+
+        uint32_t data_size = 0;
+        if (!ReadLength(base, available, offset, data_size)) return Result::kNeedMore;
+        if (data_size > max_field_size_) return Result::kError;
+        if (available - offset < data_size) return Result::kNeedMore;
+        size_t data_offset = offset;
+        offset += data_size;
+
+        frame.flags = flags;
+        frame.request_id = request_id;
+        frame.trace_data.assign(base + trace_offset, base + trace_offset + trace_size);
+        frame.opcode = static_cast<uint16_t>(opcode);
+        frame.message_type.assign(reinterpret_cast<const char*>(base + type_offset), type_size);
+        frame.payload.assign(base + data_offset, base + data_offset + data_size);
+
+        read_offset_ += offset;
+        Compact();
+        return Result::kFrame;
+    }
+
+    /**
+     * @brief 缓冲区中尚未消费的字节数
+     */
+    size_t BufferedBytes() const {
+        return buffer_.size() - read_offset_;
+    }
+
+private:
+    /**
+     * @brief 读取一个网络字节序的32位字段（长度或请求ID）
+     */
+    static bool ReadLength(const uint8_t* base, size_t available, size_t& offset, uint32_t& value) {
+        if (available - offset < 4) {
+            return false;
+        }
+        std::memcpy(&value, base + offset, 4);
+        value = ntohl(value);
+        offset += 4;
+        return true;
+    }
+
+    /**
+     * @brief 回收已消费的前缀，避免缓冲区无限增长
+     */
+    void Compact() {
+        if (read_offset_ == buffer_.size()) {
+            buffer_.clear();
+            read_offset_ = 0;
+        } else if (read_offset_ > 64 * 1024 && read_offset_ * 2 > buffer_.size()) {
+            buffer_.erase(buffer_.begin(), buffer_.begin() + read_offset_);
+            read_offset_ = 0;
+        }
+    }
+
+    std::vector<uint8_t> buffer_;
+    size_t read_offset_ = 0;
+    uint32_t max_field_size_;
+};
+
+/**
+ * @brief 请求帧的分散写描述
+ * 长度字段保存在对象内部，追踪数据、消息类型和请求体直接引用调用方的缓冲区，
+ * 整帧可以用一次writev/sendmsg发出而不必先拼接；对象持有指向自身的指针，不可拷贝
+ */
+class RequestSegments {
+public:
+    /**
+     * @param opcode 非0时以操作码代替消息类型字符串并自动加上kFlagOpcode
+     */
+    RequestSegments(uint8_t flags,
+                    const std::vector<uint8_t>& trace_data,
+                    const std::string& message_type,
+                    const std::vector<uint8_t>& request_data,
+                    uint32_t request_id = 0,
+                    uint16_t opcode = 0) {
+        if (opcode != 0) {
+            flags |= kFlagOpcode;
+        }
+
+        // 标志位与追踪数据大小，以及可选的请求ID
+        prefix_[0] = htonl((static_cast<uint32_t>(flags) << kFrameFlagsShift) |
+                           (static_cast<uint32_t>(trace_data.size()) & kTraceSizeMask));
+        prefix_[1] = htonl(request_id);
+        Add(prefix_, (flags & kFlagRequestId) ? 8 : 4);
+        Add(trace_data.data(), trace_data.size());
+
+        // 消息类型或操作码
+        if (flags & kFlagOpcode) {
+            type_size_ = htonl(opcode);
+            Add(&type_size_, 4);
+        } else {
+            type_size_ = htonl(static_cast<uint32_t>(message_type.size()));
+            Add(&type_size_, 4);
+            Add(message_type.data(), message_type.size());
+        }
+
+        // 数据
+        data_size_ = htonl(static_cast<uint32_t>(request_data.size()));
+        Add(&data_size_, 4);
+        Add(request_data.data(), request_data.size());
+    }
+
+    // 各片段只被引用，绑定临时对象会在构造结束后悬空，禁止以右值构造
+    RequestSegments(uint8_t, std::vector<uint8_t>&&, const std::string&, const std::vector<uint8_t>&,
+                    uint32_t = 0, uint16_t = 0) = delete;
+    RequestSegments(uint8_t, const std::vector<uint8_t>&, std::string&&, const std::vector<uint8_t>&,
+                    uint32_t = 0, uint16_t = 0) = delete;
+    RequestSegments(uint8_t, const std::vector<uint8_t>&, const std::string&, std::vector<uint8_t>&&,
+                    uint32_t = 0, uint16_t = 0) = delete;
+
+    RequestSegments(const RequestSegments&) = delete;
+    RequestSegments& operator=(const RequestSegments&) = delete;
+
+    iovec* Iov() {
+        return iov_;
+    }
+
+    size_t Count() const {
+        return count_;
+    }
+
+    size_t TotalSize() const {
+        size_t total = 0;
+        for (size_t i = 0; i < count_; ++i) {
+            total += iov_[i].iov_len;
+        }
+        return total;
+    }
+
+private:
+    void Add(const void* data, size_t size) {
+        if (size > 0) {
+            iov_[count_++] = iovec{const_cast<void*>(data), size};
+        }
+    }
+
+    uint32_t prefix_[2];
+    uint32_t type_size_;
+    uint32_t data_size_;
+    iovec iov_[6];
+    size_t count_ = 0;
+};
+
+/**
+ * @brief 编码请求帧为连续缓冲区
+ * @param opcode 非0时以操作码代替消息类型字符串并自动加上kFlagOpcode
+ */
+inline std::vector<uint8_t> EncodeRequest(uint8_t flags,
+                                          const std::vector<uint8_t>& trace_data,
+                                          const std::string& message_type,
+                                          const std::vector<uint8_t>& request_data,
+                                          uint32_t request_id = 0,
+                                          uint16_t opcode = 0) {
+    RequestSegments segments(flags, trace_data, message_type, request_data, request_id, opcode);
+    std::vector<uint8_t> message;
+    message.reserve(segments.TotalSize());
+    for (size_t i = 0; i < segments.Count(); ++i) {
+        const uint8_t* base = static_cast<const uint8_t*>(segments.Iov()[i].iov_base);
+        message.insert(message.end(), base, base + segments.Iov()[i].iov_len);
+    }
+    return message;
+}
+
+/**
+ * @brief 响应头: [data_size(4)][request_id(4，请求带ID时)]，与响应体分开写出以免拷贝响应体
+ */
+struct ResponseHeader {
+    uint32_t words[2];
+    size_t size;
+
+    ResponseHeader(const TcpFrame& request, size_t data_size) {
+        words[0] = htonl(static_cast<uint32_t>(data_size));
+        words[1] = htonl(request.request_id);
+        size = (request.flags & kFlagRequestId) ? 8 : 4;
+    }
+};
+
+/**
+ * @brief 编码响应: [data_size(4)][request_id(4，请求带ID时)][data]
+ */
+inline std::vector<uint8_t> EncodeResponse(const TcpFrame& request, const std::vector<uint8_t>& response_data) {
+    ResponseHeader header(request, response_data.size());
+    std::vector<uint8_t> message;
+    message.reserve(header.size + response_data.size());
+    message.insert(message.end(), (uint8_t*)header.words, (uint8_t*)header.words + header.size);
+    message.insert(message.end(), response_data.begin(), response_data.end());
+    return message;
+}
+
+} // namespace tcp_frame
+
+#endif // TCP_FRAME_H
@@ -0,0 +1,166 @@
+#ifndef TCP_IO_H
+#define TCP_IO_H
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+/**
+ * @brief 阻塞socket上的帧读写工具
+ * 写侧把一帧的多个片段用一次sendmsg发出；读侧一次recv尽量多读，后续字段直接从缓冲区取
+ */
+namespace tcp_io {
+
+/**
+ * @brief 关闭Nagle算法：每帧都是一次完整写入，不需要内核再合并小包
+ */
+inline void SetNoDelay(int fd) {
+    int opt = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+}
+
+/**
+ * @brief 建立阻塞的客户端连接
+ * @throws std::runtime_error 创建socket或连接失败
+ */
+inline int Connect(const std::string& host, int port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        throw std::runtime_error("创建客户端socket失败");
+    }
+
+    sockaddr_in server_addr{};
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_addr.s_addr = inet_addr(host.c_str());
+    server_addr.sin_port = htons(port);
+
+    if (connect(fd, (sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+        close(fd);
+        throw std::runtime_error("连接服务失败");
+    }
+
+    SetNoDelay(fd);
+    return fd;
+}
+
+/**
+ * @brief 用sendmsg发送全部片段，部分写入时跳过已发送的部分继续
+ * @return 连接出错时返回false
+ */
+inline bool SendAll(int fd, iovec* iov, size_t count) {
+    while (count > 0) {
+        msghdr message{};
+        message.msg_iov = iov;
+        message.msg_iovlen = count;
+        ssize_t n = sendmsg(fd, &message, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+
+        size_t sent = static_cast<size_t>(n);
+        while (count > 0 && sent >= iov->iov_len) {
+            sent -= iov->iov_len;
+            ++iov;
+            --count;
+        }
+        if (count > 0) {
+            iov->iov_base = static_cast<uint8_t*>(iov->iov_base) + sent;
+            iov->iov_len -= sent;
+        }
+    }
+    return true;
+}
+
+inline bool SendAll(int fd, const uint8_t* data, size_t size) {
+    iovec iov{const_cast<uint8_t*>(data), size};
+    return SendAll(fd, &iov, 1);
+}
+
+/**
+ * @brief 带缓冲的读取器
+ * 一次recv读入socket中已有的全部数据，响应头和响应体通常只需要一次系统调用
+ */
+class BufferedReader {
+public:
+    explicit BufferedReader(int fd, size_t capacity = 64 * 1024)
+        : fd_(fd), buffer_(capacity), begin_(0), end_(0) {}
+
+    /**
+     * @brief 读取恰好size个字节
+     * @param received 累计读到的字节数，失败时调用方可据此判断是否读到了部分数据
+     * @return 连接关闭或出错时返回false
+     */
+    bool ReadExact(void* out, size_t size, size_t& received) {
+        uint8_t* dest = static_cast<uint8_t*>(out);
+        while (received < size) {
+            if (begin_ == end_) {
+                // 剩余部分比缓冲区还大时直接读入目标，省去一次拷贝
+                size_t remaining = size - received;
+                if (remaining >= buffer_.size()) {
+                    ssize_t n = Recv(dest + received, remaining);
+                    if (n <= 0) {
+                        return false;
+                    }
+                    received += static_cast<size_t>(n);
+                    continue;
+                }
+                ssize_t n = Recv(buffer_.data(), buffer_.size());
+                if (n <= 0) {
+                    return false;
+                }
+                begin_ = 0;
+                end_ = static_cast<size_t>(n);
+            }
+
+            size_t chunk = std::min(end_ - begin_, size - received);
+            std::memcpy(dest + received, buffer_.data() + begin_, chunk);
+            begin_ += chunk;
+            received += chunk;
+        }
+        return true;
+    }
+
+    bool ReadExact(void* out, size_t size) {
+        size_t received = 0;
+        return ReadExact(out, size, received);
+    }
+
+    /**
+     * @brief 缓冲区中尚未消费的字节数
+     */
+    size_t Buffered() const {
+        return end_ - begin_;
+    }
+
+private:
+    ssize_t Recv(uint8_t* out, size_t size) {
+        while (true) {
+            ssize_t n = recv(fd_, out, size, 0);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            return n;
+        }
+    }
+
+    int fd_;
+    std::vector<uint8_t> buffer_;
+    size_t begin_;
+    size_t end_;
+};
+
+} // namespace tcp_io
+
+#endif // TCP_IO_H
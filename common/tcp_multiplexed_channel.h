@@ -0,0 +1,333 @@
+#ifndef TCP_MULTIPLEXED_CHANNEL_H
+#define TCP_MULTIPLEXED_CHANNEL_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+
+#include "tcp_codec.h"
+#include "tcp_context_propagation.h"
+#include "tcp_frame.h"
+#include "tcp_io.h"
+#include "tcp_opcodes.h"
+
+namespace tcp_client {
+
+/**
+ * @brief 一个在途的多路复用请求
+ */
+struct PendingCall {
+    uint32_t request_id;
+    std::future<std::vector<uint8_t>> future;
+};
+
+/**
+ * @brief 支持多路复用的长连接
+ * 每个请求带唯一请求ID，可同时有任意多个请求在途；后台读线程按ID把响应分发给对应的future。
+ * 启动读线程之前先以普通的一问一答协商请求体编码
+ */
+class TcpMultiplexedConnection {
+public:
+    TcpMultiplexedConnection(const std::string& host, int port)
+        : socket_(tcp_io::Connect(host, port)), reader_(socket_), next_request_id_(1), broken_(false) {
+        if (!Negotiate()) {
+            close(socket_);
+            throw std::runtime_error("协商编码失败");
+        }
+
+        reader_thread_ = std::thread([this]() { ReaderLoop(); });
+    }
+
+    ~TcpMultiplexedConnection() {
+        shutdown(socket_, SHUT_RDWR);
+        if (reader_thread_.joinable()) {
+            reader_thread_.join();
+        }
+        close(socket_);
+    }
+
+    TcpMultiplexedConnection(const TcpMultiplexedConnection&) = delete;
+    TcpMultiplexedConnection& operator=(const TcpMultiplexedConnection&) = delete;
+
+    /**
+     * @brief 异步发送请求，响应到达时future就绪；连接断开时future抛出异常
+     * @param binary 请求体是否为二进制编码（仅在协商成功的连接上使用）
+     * @return 请求ID与响应future；不再等待响应时应以该ID调用Cancel
+     */
+    PendingCall CallAsync(const std::string& message_type,
+                          const std::vector<uint8_t>& request_data,
+                          bool binary) {
+        uint32_t request_id = next_request_id_.fetch_add(1);
+        std::promise<std::vector<uint8_t>> promise;
+        auto future = promise.get_future();
+
+        {
+            std::lock_guard<std::mutex> lock(pending_mutex_);
+            if (broken_) {
+                throw std::runtime_error("连接已断开");
+            }
+            pending_.emplace(request_id, std::move(promise));
+        }
+
+        // 获取当前追踪上下文
+        auto trace_data = tcp_context_propagation::GetCurrentTraceContextBinary();
+        uint8_t flags = tcp_frame::kFlagKeepAlive | tcp_frame::kFlagRequestId |
+                        (binary ? tcp_frame::kFlagBinaryCodec : 0);
+        uint16_t opcode = features_.opcodes ? tcp_opcode::FindOpcode(message_type) : tcp_opcode::kInvalidOpcode;
+        tcp_frame::RequestSegments segments(flags, trace_data, message_type, request_data, request_id, opcode);
+
+        bool sent;
+        {
+            std::lock_guard<std::mutex> lock(write_mutex_);
+            sent = tcp_io::SendAll(socket_, segments.Iov(), segments.Count());
+        }
+        if (!sent) {
+            // 读线程随后会因连接断开把所有在途请求置为失败
+            shutdown(socket_, SHUT_RDWR);
+        }
+
+        return PendingCall{request_id, std::move(future)};
+    }
+
+    /**
+     * @brief 放弃等待一个在途请求，之后到达的响应被丢弃
+     * 调用方超时后必须调用，否则该请求的promise一直留在在途表中，直到连接断开
+     */
+    void Cancel(uint32_t request_id) {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        pending_.erase(request_id);
+    }
+
+    /**
+     * @brief 该连接是否协商使用二进制编码
+     */
+    bool BinaryCodec() const {
+        return features_.binary_codec;
+    }
+
+    /**
+     * @brief 连接是否已断开
+     */
+    bool IsBroken() {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        return broken_;
+    }
+
+    /**
+     * @brief 在途请求数
+     */
+    size_t PendingCount() {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        return pending_.size();
+    }
+
+private:
+    /**
+     * @brief 发送不带请求ID的协商请求并同步读取 [data_size(4)][data] 响应
+     * @return 连接是否可用
+     */
+    bool Negotiate() {
+        // 分散写只引用缓冲区，各片段须在发送完成前一直有效
+        const std::vector<uint8_t> trace_data;
+        const std::string message_type = tcp_codec::kNegotiateMessageType;
+        auto request_data = tcp_codec::MakeNegotiateRequest();
+        tcp_frame::RequestSegments segments(tcp_frame::kFlagKeepAlive, trace_data, message_type, request_data);
+        if (!tcp_io::SendAll(socket_, segments.Iov(), segments.Count())) {
+            return false;
+        }
+        uint32_t response_size = 0;
+        if (!reader_.ReadExact(&response_size, sizeof(response_size))) {
+            return false;
+        }
+        std::vector<uint8_t> response_data(ntohl(response_size));
+        if (!reader_.ReadExact(response_data.data(), response_data.size())) {
+            return false;
+        }
+        features_ = tcp_codec::ParseNegotiateResponse(response_data);
+        return true;
+    }
+
+    /**
+     * @brief 读线程：持续读取 [data_size(4)][request_id(4)][data] 并完成对应的future
+     * 经缓冲读取，同一次recv读到的多个响应不再各自触发系统调用
+     */
+    void ReaderLoop() {
+        while (true) {
+            uint32_t header[2];
+            if (!reader_.ReadExact(header, sizeof(header))) {
+                break;
+            }
+            uint32_t response_size = ntohl(header[0]);
+            uint32_t request_id = ntohl(header[1]);
+
+            std::vector<uint8_t> response_data(response_size);
+            if (!reader_.ReadExact(response_data.data(), response_size)) {
+                break;
+            }
+
+            std::lock_guard<std::mutex> lock(pending_mutex_);
+            auto it = pending_.find(request_id);
+            if (it != pending_.end()) {
+                it->second.set_value(std::move(response_data));
+                pending_.erase(it);
+            }
+        }
+
+        // 连接断开，所有在途请求失败
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        broken_ = true;
+        for (auto& entry : pending_) {
+            entry.second.set_exception(std::make_exception_ptr(std::runtime_error("连接已断开")));
+        }
+        pending_.clear();
+    }
+
+    int socket_;
+    tcp_io::BufferedReader reader_;
+    tcp_codec::NegotiatedFeatures features_;
+    std::atomic<uint32_t> next_request_id_;
+    std::mutex write_mutex_;
+    std::mutex pending_mutex_;
+    std::unordered_map<uint32_t, std::promise<std::vector<uint8_t>>> pending_;
+    bool broken_;
+    std::thread reader_thread_;
+};
+
+/**
+ * @brief 到某个后端地址的多路复用通道，由少量连接轮询承载全部并发请求
+ */
+class TcpMultiplexedChannel {
+public:
+    TcpMultiplexedChannel(const std::string& host, int port, size_t num_connections)
+        : host_(host), port_(port), slots_(num_connections > 0 ? num_connections : 1), next_(0) {}
+
+    /**
+     * @brief 轮询取出一条连接，断开的连接在下一次使用时重建
+     * 重建（阻塞的connect与编码协商）在锁外进行：先在锁内占住该槽位，同一槽位的其他调用方等待重建结果，
+     * 其他槽位不受影响。调用方持有shared_ptr，即使连接随后被替换，本次请求仍能完成或收到断开异常
+     */
+    std::shared_ptr<TcpMultiplexedConnection> NextConnection() {
+        size_t index = next_.fetch_add(1) % slots_.size();
+        Slot& slot = slots_[index];
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!slot.connection || slot.connection->IsBroken()) {
+            if (!slot.connecting) {
+                slot.connecting = true;
+                lock.unlock();
+
+                std::shared_ptr<TcpMultiplexedConnection> connection;
+                try {
+                    connection = std::make_shared<TcpMultiplexedConnection>(host_, port_);
+                } catch (...) {
+                    lock.lock();
+                    slot.connecting = false;
+                    connected_.notify_all();
+                    throw;
+                }
+
+                lock.lock();
+                slot.connection = std::move(connection);
+                slot.connecting = false;
+                connected_.notify_all();
+                break;
+            }
+            connected_.wait(lock);
+        }
+        return slot.connection;
+    }
+
+private:
+    struct Slot {
+        std::shared_ptr<TcpMultiplexedConnection> connection;
+        bool connecting = false;    // 某个调用方正在锁外重建该槽位的连接
+    };
+
+    std::string host_;
+    int port_;
+    std::mutex mutex_;
+    std::condition_variable connected_;
+    std::vector<Slot> slots_;
+    std::atomic<size_t> next_;
+};
+
+/**
+ * @brief 进程内的多路复用通道表，按"host:port"索引
+ */
+class TcpMultiplexedChannelRegistry {
+public:
+    static TcpMultiplexedChannelRegistry& Instance() {
+        static auto* registry = new TcpMultiplexedChannelRegistry();
+        return *registry;
+    }
+
+    /**
+     * @brief 设置之后新建通道的连接数
+     */
+    void SetConnectionsPerEndpoint(size_t count) {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        connections_per_endpoint_ = count;
+    }
+
+    TcpMultiplexedChannel& GetChannel(const std::string& host, int port) {
+        std::string endpoint = host + ":" + std::to_string(port);
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            auto it = channels_.find(endpoint);
+            if (it != channels_.end()) {
+                return *it->second;
+            }
+        }
+
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        auto& channel = channels_[endpoint];
+        if (!channel) {
+            channel = std::make_unique<TcpMultiplexedChannel>(host, port, connections_per_endpoint_);
+        }
+        return *channel;
+    }
+
+private:
+    TcpMultiplexedChannelRegistry() = default;
+
+    std::shared_mutex mutex_;
+    size_t connections_per_endpoint_ = 4;
+    std::map<std::string, std::unique_ptr<TcpMultiplexedChannel>> channels_;
+};
+
+/**
+ * @brief 通过多路复用通道发送TCP请求并等待响应
+ * @param timeout 等待响应的最长时间，超时抛出异常
+ */
+template<typename RequestType, typename ResponseType>
+ResponseType SendMultiplexedRequest(const std::string& host, int port,
+                                    const std::string& message_type,
+                                    const RequestType& request,
+                                    std::chrono::milliseconds timeout = std::chrono::milliseconds(30000)) {
+    auto connection = TcpMultiplexedChannelRegistry::Instance().GetChannel(host, port).NextConnection();
+    bool binary = connection->BinaryCodec();
+
+    auto call = connection->CallAsync(message_type, tcp_codec::EncodeRequest(request, binary), binary);
+    if (call.future.wait_for(timeout) != std::future_status::ready) {
+        connection->Cancel(call.request_id);
+        throw std::runtime_error("后端服务响应超时");
+    }
+    return tcp_codec::DecodeResponse<ResponseType>(call.future.get(), binary);
+}
+
+} // namespace tcp_client
+
+#endif // TCP_MULTIPLEXED_CHANNEL_H
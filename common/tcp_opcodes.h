@@ -0,0 +1,70 @@
+#ifndef TCP_OPCODES_H
+#define TCP_OPCODES_H
+
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+
+/**
+ * @brief 消息类型与数值操作码的对应表
+ * 协商支持操作码的连接上，请求帧用操作码代替消息类型字符串，服务端直接按下标分发。
+ * 操作码会写入线上协议：只能在表尾追加，不能修改或复用已有编号；不在表中的消息类型仍按字符串发送
+ */
+namespace tcp_opcode {
+
+constexpr uint16_t kInvalidOpcode = 0;
+
+struct OpcodeEntry {
+    uint16_t opcode;
+    const char* message_type;
+};
+
+inline constexpr OpcodeEntry kOpcodeTable[] = {
+    {1, "codec.negotiate"},
+    {2, "user.register"},
+    {3, "user.login"},
+    {4, "user.get"},
+    {5, "message.send"},
+    {6, "message.get"},
+    {7, "message.mark_read"},
+    {8, "notification.send"},
+    {9, "notification.get"},
+    {10, "user.get_many"},
+    {11, "user.auth"},
+    {12, "message.unread_counts"},
+    {13, "notification.subscribe"},
+    {14, "notification.send_bulk"},
+    {15, "notification.send_batch"},
+};
+
+/**
+ * @brief 表中最大操作码，服务端据此分配扁平分发数组
+ */
+constexpr uint16_t MaxOpcode() {
+    uint16_t max_opcode = kInvalidOpcode;
+    for (const auto& entry : kOpcodeTable) {
+        if (entry.opcode > max_opcode) {
+            max_opcode = entry.opcode;
+        }
+    }
+    return max_opcode;
+}
+
+/**
+ * @brief 按消息类型查找操作码，不在表中时返回kInvalidOpcode
+ */
+inline uint16_t FindOpcode(std::string_view message_type) {
+    static const auto index = []() {
+        std::unordered_map<std::string_view, uint16_t> table;
+        for (const auto& entry : kOpcodeTable) {
+            table.emplace(entry.message_type, entry.opcode);
+        }
+        return table;
+    }();
+    auto it = index.find(message_type);
+    return it != index.end() ? it->second : kInvalidOpcode;
+}
+
+} // namespace tcp_opcode
+
+#endif // TCP_OPCODES_H
@@ -0,0 +1,499 @@
+#ifndef TCP_REACTOR_H
+#define TCP_REACTOR_H
+
+#include <atomic>
+#include <cerrno>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <unistd.h>
+
+#include "tcp_frame.h"
+#include "tcp_io.h"
+
+/**
+ * @brief TCP服务端运行参数
+ */
+struct TcpServerOptions {
+    size_t reactor_threads = 1;                              // epoll事件循环线程数
+    size_t worker_threads = std::thread::hardware_concurrency(); // 业务处理线程数
+    size_t max_pending_requests = 10000;                     // 等待处理的请求上限（背压阈值）
+    uint32_t max_frame_field_size = tcp_frame::kDefaultMaxFieldSize;
+    int listen_backlog = SOMAXCONN;
+};
+
+/**
+ * @brief 由reactor持有的客户端连接
+ * 读操作只在所属的事件循环线程进行；写操作可以来自任意工作线程
+ * 一个连接上可以连续发送多个请求帧：普通帧逐个处理并按顺序应答，带请求ID的帧并发处理、乱序应答
+ */
+class TcpConnection {
+public:
+    TcpConnection(int fd, uint32_t max_frame_field_size)
+        : fd_(fd), parser_(max_frame_field_size) {}
+
+    int Fd() const {
+        return fd_;
+    }
+
+    /**
+     * @brief 发送数据，尽量直接写入socket，写不完的部分缓存到EPOLLOUT时继续发送
+     * @param data 待发送数据
+     * @param close_after 数据全部发出后是否关闭连接
+     * @return 连接已关闭时返回false
+     */
+    bool Send(const std::vector<uint8_t>& data, bool close_after = false) {
+        iovec iov{const_cast<uint8_t*>(data.data()), data.size()};
+        return SendV(&iov, 1, close_after);
+    }
+
+    /**
+     * @brief 分散写：多个片段（如响应头和响应体）用一次sendmsg发出，写不完的部分按顺序缓存
+     * @param count 片段数，不超过kMaxSegments
+     */
+    bool SendV(const iovec* iov, size_t count, bool close_after = false) {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        if (closed_) {
+            return false;
+        }
+
+        size_t written = 0;
+        if (pending_.empty()) {
+            if (!WriteSome(iov, count, written)) {
+                ShutdownLocked();
+                return false;
+            }
+        }
+        for (size_t i = 0; i < count; ++i) {
+            const uint8_t* base = static_cast<const uint8_t*>(iov[i].iov_base);
+            size_t skip = written < iov[i].iov_len ? written : iov[i].iov_len;
+            written -= skip;
+            pending_.insert(pending_.end(), base + skip, base + iov[i].iov_len);
+        }
+
+        if (close_after) {
+            close_after_flush_ = true;
+            if (pending_.empty()) {
+                ShutdownLocked();
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief socket重新可写时由事件循环调用，继续发送缓存数据
+     */
+    void OnWritable() {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        if (closed_ || pending_.empty()) {
+            return;
+        }
+
+        size_t written = 0;
+        iovec iov{pending_.data(), pending_.size()};
+        if (!WriteSome(&iov, 1, written)) {
+            ShutdownLocked();
+            return;
+        }
+        pending_.erase(pending_.begin(), pending_.begin() + written);
+
+        if (pending_.empty() && close_after_flush_) {
+            ShutdownLocked();
+        }
+    }
+
+    /**
+     * @brief 标记连接已关闭，之后的写操作都会被忽略（事件循环在close前调用）
+     */
+    void MarkClosed() {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        closed_ = true;
+        pending_.clear();
+    }
+
+    static constexpr size_t kMaxSegments = 4;
+
+private:
+    friend class TcpReactor;
+
+    /**
+     * @brief 非阻塞写，直到写完或内核缓冲区满
+     * @param written 已写出的字节数（跨片段累计）
+     * @return 发生不可恢复的错误时返回false
+     */
+    bool WriteSome(const iovec* iov, size_t count, size_t& written) {
+        size_t total = 0;
+        for (size_t i = 0; i < count; ++i) {
+            total += iov[i].iov_len;
+        }
+
+        while (written < total) {
+            // 跳过已写出的部分
+            iovec remaining[kMaxSegments];
+            size_t remaining_count = 0;
+            size_t skip = written;
+            for (size_t i = 0; i < count; ++i) {
+                if (skip >= iov[i].iov_len) {
+                    skip -= iov[i].iov_len;
+                    continue;
+                }
+                remaining[remaining_count++] = iovec{static_cast<uint8_t*>(iov[i].iov_base) + skip,
+                                                     iov[i].iov_len - skip};
+                skip = 0;
+            }
+
+            msghdr message{};
+            message.msg_iov = remaining;
+            message.msg_iovlen = remaining_count;
+            ssize_t n = sendmsg(fd_, &message, MSG_NOSIGNAL);
+            if (n > 0) {
+                written += static_cast<size_t>(n);
+            } else if (n < 0 && errno == EINTR) {
+                continue;
+            } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                return true;
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief 关闭读写两端，事件循环会收到EPOLLHUP并负责真正close
+     */
+    void ShutdownLocked() {
+        shutdown(fd_, SHUT_RDWR);
+    }
+
+    int fd_;
+
+    // 读侧状态，由read_mutex_保护（事件循环线程追加数据，工作线程完成请求后继续解析）
+    std::mutex read_mutex_;
+    tcp_frame::TcpFrameParser parser_;
+    bool in_flight_ = false;     // 是否有顺序请求正在处理
+    bool keep_alive_ = true;     // 最近一个请求是否要求保持连接
+    bool peer_closed_ = false;   // 对端已半关闭，等正在处理的请求应答后再关闭
+
+    std::mutex write_mutex_;
+    std::vector<uint8_t> pending_;
+    bool close_after_flush_ = false;
+    bool closed_ = false;
+};
+
+/**
+ * @brief 基于边缘触发epoll的多事件循环reactor
+ * 负责所有客户端socket的非阻塞读写与增量帧解析，完整的帧通过回调交给上层
+ */
+class TcpReactor {
+public:
+    using FrameCallback = std::function<void(const std::shared_ptr<TcpConnection>&, tcp_frame::TcpFrame&&)>;
+
+    TcpReactor(const TcpServerOptions& options, FrameCallback on_frame)
+        : options_(options), on_frame_(std::move(on_frame)), running_(false), next_loop_(0) {
+    }
+
+    ~TcpReactor() {
+        Stop();
+    }
+
+    TcpReactor(const TcpReactor&) = delete;
+    TcpReactor& operator=(const TcpReactor&) = delete;
+
+    /**
+     * @brief 创建事件循环并启动线程
+     */
+    void Start() {
+        size_t num_loops = options_.reactor_threads > 0 ? options_.reactor_threads : 1;
+        for (size_t i = 0; i < num_loops; ++i) {
+            auto loop = std::make_unique<EventLoop>();
+            loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+            loop->wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (loop->epoll_fd < 0 || loop->wakeup_fd < 0) {
+                throw std::runtime_error("创建epoll事件循环失败");
+            }
+
+            epoll_event ev{};
+            ev.events = EPOLLIN;
+            ev.data.fd = loop->wakeup_fd;
+            epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, loop->wakeup_fd, &ev);
+
+            loops_.push_back(std::move(loop));
+        }
+
+        running_ = true;
+        for (auto& loop : loops_) {
+            EventLoop* raw = loop.get();
+            raw->thread = std::thread([this, raw]() {
+                RunLoop(*raw);
+            });
+        }
+    }
+
+    /**
+     * @brief 停止所有事件循环并关闭全部连接
+     */
+    void Stop() {
+        if (!running_.exchange(false)) {
+            return;
+        }
+
+        for (auto& loop : loops_) {
+            uint64_t one = 1;
+            ssize_t ignored = write(loop->wakeup_fd, &one, sizeof(one));
+            (void)ignored;
+        }
+
+        for (auto& loop : loops_) {
+            if (loop->thread.joinable()) {
+                loop->thread.join();
+            }
+
+            std::lock_guard<std::mutex> lock(loop->mutex);
+            for (auto& entry : loop->connections) {
+                entry.second->MarkClosed();
+                close(entry.first);
+            }
+            loop->connections.clear();
+            close(loop->wakeup_fd);
+            close(loop->epoll_fd);
+        }
+        loops_.clear();
+    }
+
+    /**
+     * @brief 接管一个已accept的非阻塞socket，按轮询分配给事件循环
+     */
+    void AddConnection(int fd) {
+        if (loops_.empty()) {
+            close(fd);
+            return;
+        }
+
+        tcp_io::SetNoDelay(fd);
+
+        EventLoop& loop = *loops_[next_loop_.fetch_add(1) % loops_.size()];
+        auto connection = std::make_shared<TcpConnection>(fd, options_.max_frame_field_size);
+        {
+            std::lock_guard<std::mutex> lock(loop.mutex);
+            loop.connections[fd] = connection;
+        }
+
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        ev.data.fd = fd;
+        if (epoll_ctl(loop.epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            std::lock_guard<std::mutex> lock(loop.mutex);
+            loop.connections.erase(fd);
+            close(fd);
+        }
+    }
+
+    /**
+     * @brief 工作线程处理完请求后调用，写回响应（响应头与响应体一次sendmsg发出）
+     * 带请求ID的请求可乱序应答，直接发送即可；顺序请求在应答后继续处理该连接上已缓存的下一个请求，
+     * 未要求保持连接时发送完响应即关闭连接
+     */
+    void OnRequestComplete(const std::shared_ptr<TcpConnection>& connection,
+                           const tcp_frame::TcpFrame& request,
+                           const std::vector<uint8_t>& response_data) {
+        tcp_frame::ResponseHeader header(request, response_data.size());
+        iovec iov[2] = {
+            {header.words, header.size},
+            {const_cast<uint8_t*>(response_data.data()), response_data.size()}
+        };
+
+        if (request.flags & tcp_frame::kFlagRequestId) {
+            connection->SendV(iov, 2);
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(connection->read_mutex_);
+        connection->in_flight_ = false;
+
+        if (!connection->keep_alive_) {
+            connection->SendV(iov, 2, true);
+            return;
+        }
+
+        connection->SendV(iov, 2);
+        if (!DispatchNext(connection) || (connection->peer_closed_ && !connection->in_flight_)) {
+            connection->Send({}, true);
+        }
+    }
+
+    /**
+     * @brief 当前连接总数
+     */
+    size_t ConnectionCount() {
+        size_t count = 0;
+        for (auto& loop : loops_) {
+            std::lock_guard<std::mutex> lock(loop->mutex);
+            count += loop->connections.size();
+        }
+        return count;
+    }
+
+private:
+    struct EventLoop {
+        int epoll_fd = -1;
+        int wakeup_fd = -1;
+        std::thread thread;
+        std::mutex mutex;
+        std::unordered_map<int, std::shared_ptr<TcpConnection>> connections;
+    };
+
+    /**
+     * @brief 事件循环主体
+     */
+    void RunLoop(EventLoop& loop) {
+        constexpr int kMaxEvents = 256;
+        epoll_event events[kMaxEvents];
+
+        while (running_) {
+            int n = epoll_wait(loop.epoll_fd, events, kMaxEvents, -1);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                std::cerr << "epoll_wait失败: " << errno << std::endl;
+                break;
+            }
+
+            for (int i = 0; i < n; ++i) {
+                int fd = events[i].data.fd;
+                if (fd == loop.wakeup_fd) {
+                    uint64_t value;
+                    ssize_t ignored = read(loop.wakeup_fd, &value, sizeof(value));
+                    (void)ignored;
+                    continue;
+                }
+
+                std::shared_ptr<TcpConnection> connection = FindConnection(loop, fd);
+                if (!connection) {
+                    continue;
+                }
+
+                uint32_t mask = events[i].events;
+                if (mask & EPOLLOUT) {
+                    connection->OnWritable();
+                }
+                if (mask & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+                    bool peer_closing = (mask & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) != 0;
+                    if (!HandleReadable(connection, peer_closing)) {
+                        CloseConnection(loop, connection);
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief 读空socket并派发完整帧
+     * 一次recv没有填满缓冲区说明内核中的数据已经读完，不必再多一次以EAGAIN结束的recv；
+     * 对端正在关闭时则一直读到返回0；对端半关闭（shutdown(SHUT_WR)）时若仍有顺序请求在处理，
+     * 推迟到最后一个响应写出后再关闭，由OnRequestComplete负责
+     * @return 连接需要关闭时返回false
+     */
+    bool HandleReadable(const std::shared_ptr<TcpConnection>& connection, bool peer_closing) {
+        uint8_t buffer[64 * 1024];
+        bool peer_closed = false;
+
+        while (true) {
+            ssize_t n = recv(connection->Fd(), buffer, sizeof(buffer), 0);
+            if (n > 0) {
+                std::lock_guard<std::mutex> lock(connection->read_mutex_);
+                connection->parser_.Append(buffer, static_cast<size_t>(n));
+                if (static_cast<size_t>(n) < sizeof(buffer) && !peer_closing) {
+                    break;
+                }
+            } else if (n == 0) {
+                peer_closed = true;
+                break;
+            } else if (errno == EINTR) {
+                continue;
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            } else {
+                return false;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(connection->read_mutex_);
+        if (!DispatchNext(connection)) {
+            return false;
+        }
+        if (peer_closed && connection->in_flight_) {
+            connection->peer_closed_ = true;
+            return true;
+        }
+        return !peer_closed;
+    }
+
+    /**
+     * @brief 解析并派发缓冲区中的完整帧
+     * 带请求ID的帧全部立即派发（可并发处理）；顺序帧一次只派发一个，应答后再继续
+     * 调用方需持有read_mutex_
+     * @return 帧格式非法时返回false
+     */
+    bool DispatchNext(const std::shared_ptr<TcpConnection>& connection) {
+        while (!connection->in_flight_ && connection->keep_alive_) {
+            tcp_frame::TcpFrame frame;
+            auto result = connection->parser_.Next(frame);
+            if (result == tcp_frame::TcpFrameParser::Result::kError) {
+                return false;
+            }
+            if (result == tcp_frame::TcpFrameParser::Result::kNeedMore) {
+                break;
+            }
+
+            connection->keep_alive_ = (frame.flags & tcp_frame::kFlagKeepAlive) != 0;
+            if (!(frame.flags & tcp_frame::kFlagRequestId)) {
+                connection->in_flight_ = true;
+            }
+            on_frame_(connection, std::move(frame));
+        }
+        return true;
+    }
+
+    std::shared_ptr<TcpConnection> FindConnection(EventLoop& loop, int fd) {
+        std::lock_guard<std::mutex> lock(loop.mutex);
+        auto it = loop.connections.find(fd);
+        if (it == loop.connections.end()) {
+            return nullptr;
+        }
+        return it->second;
+    }
+
+    /**
+     * @brief 注销并关闭连接，只在所属事件循环线程调用
+     */
+    void CloseConnection(EventLoop& loop, const std::shared_ptr<TcpConnection>& connection) {
+        int fd = connection->Fd();
+        epoll_ctl(loop.epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+        {
+            std::lock_guard<std::mutex> lock(loop.mutex);
+            loop.connections.erase(fd);
+        }
+        connection->MarkClosed();
+        close(fd);
+    }
+
+    TcpServerOptions options_;
+    FrameCallback on_frame_;
+    std::atomic<bool> running_;
+    std::atomic<size_t> next_loop_;
+    std::vector<std::unique_ptr<EventLoop>> loops_;
+};
+
+#endif // TCP_REACTOR_H
@@ -1,6 +1,7 @@
 #ifndef TCP_SERVICE_BASE_H
 #define TCP_SERVICE_BASE_H
 
+#include <array>
 #include <string>
 #include <memory>
 #include <thread>
@@ -14,14 +15,23 @@
 #include <vector>
 #include <map>
 #include <mutex>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 
 #include "telemetry.h"
 #include "tcp_context_propagation.h"
+#include "tcp_client.h"
+#include "tcp_codec.h"
+#include "tcp_frame.h"
+#include "tcp_opcodes.h"
+#include "tcp_reactor.h"
+#include "worker_pool.h"
 #include "models.h"
 
 /**
  * @brief TCP服务基类，提供基本的TCP服务生命周期管理和遥测集成
  * 使用优化的TCP上下文传播替代HTTP方式
+ * 连接由epoll reactor统一管理，完整的请求帧交给有界工作线程池处理
  */
 class TcpServiceBase {
 public:
@@ -35,7 +45,7 @@ public:
     TcpServiceBase(const std::string& service_name, const std::string& service_version,
                    const std::string& host, int port)
         : service_name_(service_name), service_version_(service_version),
-          host_(host), port_(port), running_(false), server_socket_(-1) {
+          host_(host), port_(port), running_(false), server_socket_(-1), accept_wakeup_fd_(-1) {
     }
     
     /**
@@ -53,10 +63,12 @@ public:
         Telemetry::InitTelemetry(service_name_, service_version_);
         
         // 注册处理器
+        RegisterHandler<tcp_codec::NegotiateRequest, tcp_codec::NegotiateResponse>(
+            tcp_codec::kNegotiateMessageType, tcp_codec::Negotiate);
         RegisterHandlers();
         
-        // 创建TCP监听socket
-        server_socket_ = socket(AF_INET, SOCK_STREAM, 0);
+        // 创建TCP监听socket（非阻塞，由accept线程通过epoll驱动）
+        server_socket_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
         if (server_socket_ < 0) {
             throw std::runtime_error("创建socket失败");
         }
@@ -77,11 +89,26 @@ public:
         }
         
         // 开始监听
-        if (listen(server_socket_, 10) < 0) {
+        if (listen(server_socket_, server_options_.listen_backlog) < 0) {
             close(server_socket_);
             throw std::runtime_error("监听失败");
         }
         
+        accept_wakeup_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (accept_wakeup_fd_ < 0) {
+            close(server_socket_);
+            throw std::runtime_error("创建eventfd失败");
+        }
+        
+        // 创建工作线程池和reactor
+        worker_pool_ = std::make_unique<WorkerPool>(
+            server_options_.worker_threads, server_options_.max_pending_requests);
+        reactor_ = std::make_unique<TcpReactor>(server_options_,
+            [this](const std::shared_ptr<TcpConnection>& connection, tcp_frame::TcpFrame&& frame) {
+                DispatchFrame(connection, std::move(frame));
+            });
+        reactor_->Start();
+        
         running_ = true;
         std::cout << "TCP服务 " << service_name_ << " 运行于 " << host_ << ":" << port_ << std::endl;
         
@@ -106,13 +133,34 @@ public:
 
         running_ = false;
         
+        // 唤醒accept线程
+        if (accept_wakeup_fd_ >= 0) {
+            uint64_t one = 1;
+            ssize_t ignored = write(accept_wakeup_fd_, &one, sizeof(one));
+            (void)ignored;
+        }
+        
+        if (server_thread_.joinable()) {
+            server_thread_.join();
+        }
+        
         if (server_socket_ >= 0) {
             close(server_socket_);
             server_socket_ = -1;
         }
         
-        if (server_thread_.joinable()) {
-            server_thread_.join();
+        if (accept_wakeup_fd_ >= 0) {
+            close(accept_wakeup_fd_);
+            accept_wakeup_fd_ = -1;
+        }
+        
+        // 先停止reactor不再接收新请求，再停止工作线程
+        if (reactor_) {
+            reactor_->Stop();
+        }
+        
+        if (worker_pool_) {
+            worker_pool_->Stop();
         }
         
         if (health_check_thread_.joinable()) {
@@ -138,238 +186,302 @@ protected:
      */
     virtual void RegisterHandlers() = 0;
 
+    /**
+     * @brief 已注册的处理器，span名称在注册时预先拼好
+     * 同步处理器返回响应；异步处理器通过传入的回调写回响应，回调可在处理器返回之后、在任意线程调用
+     */
+    struct HandlerEntry {
+        std::string message_type;
+        std::string span_name;
+        std::function<std::vector<uint8_t>(const std::vector<uint8_t>&, bool)> handler;
+        std::function<void(const std::vector<uint8_t>&, bool,
+                           std::function<void(const std::vector<uint8_t>&)>)> async_handler;
+    };
+
+    /**
+     * @brief 异步处理器写回响应的回调，只有第一次调用生效
+     */
+    template<typename ResponseType>
+    using Responder = std::function<void(const ResponseType&)>;
+
     /**
      * @brief 注册处理器
+     * 请求体按帧标志以二进制或JSON解码，响应使用与请求相同的编码；
+     * 消息类型在操作码表中时同时登记到按操作码下标的分发数组
      */
     template<typename RequestType, typename ResponseType>
     void RegisterHandler(const std::string& message_type,
                         std::function<ResponseType(const RequestType&)> handler) {
-        handlers_[message_type] = [handler](const std::vector<uint8_t>& request_data) -> std::vector<uint8_t> {
-            // 反序列化请求
-            auto json_str = std::string(request_data.begin(), request_data.end());
-            auto json_data = nlohmann::json::parse(json_str);
-            RequestType request = json_data.get<RequestType>();
-            
-            // 处理请求
-            auto response = handler(request);
-            
-            // 序列化响应
-            nlohmann::json json_response = response;
-            auto response_str = json_response.dump();
-            return std::vector<uint8_t>(response_str.begin(), response_str.end());
+        auto& entry = AddHandlerEntry(message_type);
+        entry.handler = [handler](const std::vector<uint8_t>& request_data,
+                                  bool binary) -> std::vector<uint8_t> {
+            return EncodeResponse(handler(DecodeRequest<RequestType>(request_data, binary)), binary);
         };
     }
 
     /**
-     * @brief 发送TCP请求到其他服务
+     * @brief 注册异步处理器，用于需要等待外部事件才能应答的请求（如长轮询）
+     * 处理器返回后工作线程即被释放，连接上的其他请求不受影响；之后由事件所在线程调用responder写回响应。
+     * 处理器同步抛出异常且尚未应答时返回错误响应
+     */
+    template<typename RequestType, typename ResponseType>
+    void RegisterAsyncHandler(const std::string& message_type,
+                              std::function<void(const RequestType&, Responder<ResponseType>)> handler) {
+        auto& entry = AddHandlerEntry(message_type);
+        entry.async_handler = [handler](const std::vector<uint8_t>& request_data, bool binary,
+                                        std::function<void(const std::vector<uint8_t>&)> complete) {
+            handler(DecodeRequest<RequestType>(request_data, binary),
+                    [binary, complete](const ResponseType& response) {
+                        complete(EncodeResponse(response, binary));
+                    });
+        };
+    }
+
+    /**
+     * @brief 发送TCP请求到其他服务（复用长连接）
      */
     template<typename RequestType, typename ResponseType>
     ResponseType SendTcpRequest(const std::string& host, int port,
                                const std::string& message_type,
                                const RequestType& request) {
-        // 创建连接
-        int client_socket = socket(AF_INET, SOCK_STREAM, 0);
-        if (client_socket < 0) {
-            throw std::runtime_error("创建客户端socket失败");
-        }
-        
-        sockaddr_in server_addr{};
-        server_addr.sin_family = AF_INET;
-        server_addr.sin_addr.s_addr = inet_addr(host.c_str());
-        server_addr.sin_port = htons(port);
+        return tcp_client::SendRequest<RequestType, ResponseType>(host, port, message_type, request);
+    }
+
+private:
+    /**
+     * @brief 创建处理器条目，消息类型在操作码表中时同时登记到扁平分发数组
+     */
+    HandlerEntry& AddHandlerEntry(const std::string& message_type) {
+        auto& entry = handlers_[message_type];
+        entry.message_type = message_type;
+        entry.span_name = service_name_ + "." + message_type;
         
-        if (connect(client_socket, (sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
-            close(client_socket);
-            throw std::runtime_error("连接服务失败");
+        uint16_t opcode = tcp_opcode::FindOpcode(message_type);
+        if (opcode != tcp_opcode::kInvalidOpcode) {
+            opcode_handlers_[opcode] = &entry;
         }
-        
-        try {
-            // 获取当前追踪上下文
-            auto trace_data = tcp_context_propagation::GetCurrentTraceContextBinary();
-            
-            // 构造消息格式: [trace_data_size(4)][trace_data][msg_type_size(4)][msg_type][data_size(4)][data]
-            std::vector<uint8_t> message;
-            
-            // 追踪数据大小
-            uint32_t trace_size = htonl(static_cast<uint32_t>(trace_data.size()));
-            message.insert(message.end(), (uint8_t*)&trace_size, (uint8_t*)&trace_size + 4);
-            
-            // 追踪数据
-            message.insert(message.end(), trace_data.begin(), trace_data.end());
-            
-            // 消息类型大小
-            uint32_t msg_type_size = htonl(static_cast<uint32_t>(message_type.size()));
-            message.insert(message.end(), (uint8_t*)&msg_type_size, (uint8_t*)&msg_type_size + 4);
-            
-            // 消息类型
-            message.insert(message.end(), message_type.begin(), message_type.end());
-            
-            // 序列化请求数据
-            nlohmann::json json_request = request;
-            auto request_str = json_request.dump();
-            std::vector<uint8_t> request_data(request_str.begin(), request_str.end());
-            
-            // 数据大小
-            uint32_t data_size = htonl(static_cast<uint32_t>(request_data.size()));
-            message.insert(message.end(), (uint8_t*)&data_size, (uint8_t*)&data_size + 4);
-            
-            // 数据
-            message.insert(message.end(), request_data.begin(), request_data.end());
-            
-            // 发送消息
-            send(client_socket, message.data(), message.size(), 0);
-            
-            // 接收响应大小
-            uint32_t response_size;
-            recv(client_socket, &response_size, 4, MSG_WAITALL);
-            response_size = ntohl(response_size);
-            
-            // 接收响应数据
-            std::vector<uint8_t> response_data(response_size);
-            recv(client_socket, response_data.data(), response_size, MSG_WAITALL);
-            
-            // 反序列化响应
-            auto json_str = std::string(response_data.begin(), response_data.end());
-            auto json_data = nlohmann::json::parse(json_str);
-            ResponseType response = json_data.get<ResponseType>();
-            
-            close(client_socket);
-            return response;
-            
-        } catch (...) {
-            close(client_socket);
-            throw;
+        return entry;
+    }
+    
+    /**
+     * @brief 按帧标志以二进制或JSON解码请求体
+     */
+    template<typename RequestType>
+    static RequestType DecodeRequest(const std::vector<uint8_t>& request_data, bool binary) {
+        if (binary) {
+            return binary_codec::Decode<RequestType>(request_data.data(), request_data.size());
         }
+        auto json_data = nlohmann::json::parse(request_data.begin(), request_data.end());
+        return json_data.get<RequestType>();
     }
-
-private:
+    
+    /**
+     * @brief 以与请求相同的编码序列化响应
+     */
+    template<typename ResponseType>
+    static std::vector<uint8_t> EncodeResponse(const ResponseType& response, bool binary) {
+        if (binary) {
+            std::vector<uint8_t> response_data{tcp_codec::kPayloadBinary};
+            binary_codec::EncodeTo(response, response_data);
+            return response_data;
+        }
+        nlohmann::json json_response = response;
+        auto response_str = json_response.dump();
+        return std::vector<uint8_t>(response_str.begin(), response_str.end());
+    }
+    
     /**
-     * @brief 服务器主循环
+     * @brief 服务器主循环，负责accept并把连接交给reactor
      */
     void ServerLoop() {
+        int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd < 0) {
+            std::cerr << "创建accept epoll失败" << std::endl;
+            return;
+        }
+        
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = server_socket_;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, server_socket_, &ev);
+        ev.data.fd = accept_wakeup_fd_;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, accept_wakeup_fd_, &ev);
+        
+        epoll_event events[2];
         while (running_) {
-            sockaddr_in client_addr{};
-            socklen_t client_len = sizeof(client_addr);
-            
-            int client_socket = accept(server_socket_, (sockaddr*)&client_addr, &client_len);
-            if (client_socket < 0) {
-                if (running_) {
-                    std::cerr << "接受连接失败" << std::endl;
+            int n = epoll_wait(epoll_fd, events, 2, -1);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
                 }
-                continue;
+                std::cerr << "accept epoll_wait失败" << std::endl;
+                break;
             }
             
-            // 处理客户端连接
-            std::thread([this, client_socket]() {
-                HandleClient(client_socket);
-            }).detach();
+            for (int i = 0; i < n; ++i) {
+                if (events[i].data.fd != server_socket_) {
+                    continue;
+                }
+                
+                // 一次性接受所有排队的连接
+                while (running_) {
+                    sockaddr_in client_addr{};
+                    socklen_t client_len = sizeof(client_addr);
+                    int client_socket = accept4(server_socket_, (sockaddr*)&client_addr, &client_len,
+                                                SOCK_NONBLOCK | SOCK_CLOEXEC);
+                    if (client_socket < 0) {
+                        if (errno == EINTR) {
+                            continue;
+                        }
+                        if (errno != EAGAIN && errno != EWOULDBLOCK && running_) {
+                            std::cerr << "接受连接失败" << std::endl;
+                        }
+                        break;
+                    }
+                    
+                    reactor_->AddConnection(client_socket);
+                }
+            }
+        }
+        
+        close(epoll_fd);
+    }
+    
+    /**
+     * @brief 将完整的请求帧交给工作线程池，队列已满时立即返回繁忙错误
+     */
+    void DispatchFrame(const std::shared_ptr<TcpConnection>& connection, tcp_frame::TcpFrame&& frame) {
+        auto shared_frame = std::make_shared<tcp_frame::TcpFrame>(std::move(frame));
+        bool accepted = worker_pool_->TrySubmit([this, connection, shared_frame]() {
+            HandleFrame(connection, shared_frame);
+        });
+        
+        if (!accepted) {
+            // 带请求ID的连接上还有其他请求在处理，只拒绝本请求；顺序连接直接关闭
+            bool multiplexed = (shared_frame->flags & tcp_frame::kFlagRequestId) != 0;
+            connection->Send(tcp_frame::EncodeResponse(
+                *shared_frame, MakeErrorResponse(*shared_frame, "服务繁忙，请稍后重试")), !multiplexed);
         }
     }
     
     /**
-     * @brief 处理客户端连接
+     * @brief 在工作线程中处理一个请求帧并写回响应
+     * 异步处理器的响应由其回调写回，帧由回调持有直到应答
      */
-    void HandleClient(int client_socket) {
+    void HandleFrame(const std::shared_ptr<TcpConnection>& connection,
+                     const std::shared_ptr<tcp_frame::TcpFrame>& shared_frame) {
+        const tcp_frame::TcpFrame& frame = *shared_frame;
+        std::vector<uint8_t> response_data;
+        
         try {
-            // 读取追踪数据大小
-            uint32_t trace_size;
-            if (recv(client_socket, &trace_size, 4, MSG_WAITALL) != 4) {
-                close(client_socket);
-                return;
-            }
-            trace_size = ntohl(trace_size);
-            
-            // 读取追踪数据
-            std::vector<uint8_t> trace_data(trace_size);
-            if (recv(client_socket, trace_data.data(), trace_size, MSG_WAITALL) != trace_size) {
-                close(client_socket);
-                return;
-            }
-            
             // 应用追踪上下文
-            auto context_token = tcp_context_propagation::SetTraceContextFromBinary(trace_data);
+            auto context_token = tcp_context_propagation::SetTraceContextFromBinary(frame.trace_data);
             
-            // 读取消息类型大小
-            uint32_t msg_type_size;
-            if (recv(client_socket, &msg_type_size, 4, MSG_WAITALL) != 4) {
-                close(client_socket);
-                return;
-            }
-            msg_type_size = ntohl(msg_type_size);
-            
-            // 读取消息类型
-            std::vector<uint8_t> msg_type_data(msg_type_size);
-            if (recv(client_socket, msg_type_data.data(), msg_type_size, MSG_WAITALL) != msg_type_size) {
-                close(client_socket);
-                return;
-            }
-            std::string message_type(msg_type_data.begin(), msg_type_data.end());
+            // 创建span进行追踪，已注册的消息类型直接使用预先拼好的span名称
+            const HandlerEntry* entry = FindHandler(frame);
+            auto scope = entry ? CreateSpan(entry->span_name)
+                               : CreateSpan(service_name_ + "." + MessageTypeName(frame));
+            auto span = GetCurrentSpan();
             
-            // 读取数据大小
-            uint32_t data_size;
-            if (recv(client_socket, &data_size, 4, MSG_WAITALL) != 4) {
-                close(client_socket);
-                return;
+            // 未被采样的请求不构造属性
+            if (span->IsRecording()) {
+                if (entry) {
+                    span->SetAttribute("message.type", entry->message_type);
+                }
+                span->SetAttribute("service.name", service_name_);
+                span->SetAttribute("protocol", "tcp");
             }
-            data_size = ntohl(data_size);
             
-            // 读取数据
-            std::vector<uint8_t> request_data(data_size);
-            if (recv(client_socket, request_data.data(), data_size, MSG_WAITALL) != data_size) {
-                close(client_socket);
+            // 处理请求
+            if (entry && entry->async_handler) {
+                HandleAsync(*entry, connection, shared_frame);
                 return;
             }
-            
-            // 创建span进行追踪
-            auto scope = CreateSpan(service_name_ + "." + message_type);
-            auto span = GetCurrentSpan();
-            
-            span->SetAttribute("message.type", message_type);
-            span->SetAttribute("service.name", service_name_);
-            span->SetAttribute("protocol", "tcp");
-            
-            // 处理请求
-            std::vector<uint8_t> response_data;
-            
-            auto handler_it = handlers_.find(message_type);
-            if (handler_it != handlers_.end()) {
+            if (entry) {
                 try {
-                    response_data = handler_it->second(request_data);
+                    bool binary = (frame.flags & tcp_frame::kFlagBinaryCodec) != 0;
+                    response_data = entry->handler(frame.payload, binary);
                     span->SetStatus(trace::StatusCode::kOk);
                 } catch (const std::exception& e) {
                     span->SetStatus(trace::StatusCode::kError, e.what());
                     
                     // 创建错误响应
-                    nlohmann::json error_response = {
-                        {"success", false},
-                        {"message", e.what()}
-                    };
-                    auto error_str = error_response.dump();
-                    response_data = std::vector<uint8_t>(error_str.begin(), error_str.end());
+                    response_data = MakeErrorResponse(frame, e.what());
                 }
             } else {
                 span->SetStatus(trace::StatusCode::kError, "未知消息类型");
-                
-                nlohmann::json error_response = {
-                    {"success", false},
-                    {"message", "未知消息类型: " + message_type}
-                };
-                auto error_str = error_response.dump();
-                response_data = std::vector<uint8_t>(error_str.begin(), error_str.end());
+                response_data = MakeErrorResponse(frame, "未知消息类型: " + MessageTypeName(frame));
             }
             
-            // 发送响应大小
-            uint32_t response_size = htonl(static_cast<uint32_t>(response_data.size()));
-            send(client_socket, &response_size, 4, 0);
-            
-            // 发送响应数据
-            send(client_socket, response_data.data(), response_data.size(), 0);
-            
         } catch (const std::exception& e) {
-            std::cerr << "处理客户端连接时出错: " << e.what() << std::endl;
+            std::cerr << "处理客户端请求时出错: " << e.what() << std::endl;
+            response_data = MakeErrorResponse(frame, e.what());
         }
         
-        close(client_socket);
+        // 发送响应，顺序连接会继续处理该连接上的下一个帧
+        reactor_->OnRequestComplete(connection, frame, response_data);
+    }
+    
+    /**
+     * @brief 调用异步处理器，回调保证只写回一次响应
+     */
+    void HandleAsync(const HandlerEntry& entry, const std::shared_ptr<TcpConnection>& connection,
+                     const std::shared_ptr<tcp_frame::TcpFrame>& frame) {
+        auto span = GetCurrentSpan();
+        auto answered = std::make_shared<std::atomic<bool>>(false);
+        auto complete = [this, connection, frame, answered](const std::vector<uint8_t>& response_data) {
+            if (!answered->exchange(true)) {
+                reactor_->OnRequestComplete(connection, *frame, response_data);
+            }
+        };
+        
+        try {
+            bool binary = (frame->flags & tcp_frame::kFlagBinaryCodec) != 0;
+            entry.async_handler(frame->payload, binary, complete);
+            span->SetStatus(trace::StatusCode::kOk);
+        } catch (const std::exception& e) {
+            span->SetStatus(trace::StatusCode::kError, e.what());
+            complete(MakeErrorResponse(*frame, e.what()));
+        }
+    }
+    
+    /**
+     * @brief 查找帧对应的处理器：操作码帧直接按下标取，旧格式帧按消息类型字符串查找
+     */
+    const HandlerEntry* FindHandler(const tcp_frame::TcpFrame& frame) const {
+        if (frame.flags & tcp_frame::kFlagOpcode) {
+            return frame.opcode < opcode_handlers_.size() ? opcode_handlers_[frame.opcode] : nullptr;
+        }
+        auto it = handlers_.find(frame.message_type);
+        return it != handlers_.end() ? &it->second : nullptr;
+    }
+    
+    /**
+     * @brief 帧的消息类型，用于未知消息类型的日志和错误信息
+     */
+    static std::string MessageTypeName(const tcp_frame::TcpFrame& frame) {
+        if (frame.flags & tcp_frame::kFlagOpcode) {
+            return "#" + std::to_string(frame.opcode);
+        }
+        return frame.message_type;
+    }
+    
+    /**
+     * @brief 构造JSON错误响应，二进制请求的响应带上JSON编码标记
+     * 异常信息可能带有请求中的原始字节，非法UTF-8按替换字符输出，保证本函数不抛出
+     */
+    static std::vector<uint8_t> MakeErrorResponse(const tcp_frame::TcpFrame& frame, const std::string& message) {
+        nlohmann::json error_response = {
+            {"success", false},
+            {"message", message}
+        };
+        auto error_str = error_response.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+        std::vector<uint8_t> response_data;
+        if (frame.flags & tcp_frame::kFlagBinaryCodec) {
+            response_data.push_back(tcp_codec::kPayloadJson);
+        }
+        response_data.insert(response_data.end(), error_str.begin(), error_str.end());
+        return response_data;
     }
     
     /**
@@ -395,11 +507,18 @@ protected:
     std::atomic<bool> running_;
     
     int server_socket_;
+    int accept_wakeup_fd_;
     std::thread server_thread_;
     std::thread health_check_thread_;
     
-    // 消息处理器映射
-    std::map<std::string, std::function<std::vector<uint8_t>(const std::vector<uint8_t>&)>> handlers_;
+    // 服务端运行参数（子类可在Start之前调整）
+    TcpServerOptions server_options_;
+    std::unique_ptr<TcpReactor> reactor_;
+    std::unique_ptr<WorkerPool> worker_pool_;
+    
+    // 消息处理器映射，以及按操作码下标的扁平分发数组（元素指向handlers_中的条目）
+    std::map<std::string, HandlerEntry> handlers_;
+    std::array<const HandlerEntry*, tcp_opcode::MaxOpcode() + 1> opcode_handlers_{};
     std::mutex handlers_mutex_;
 };
 
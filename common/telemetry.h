@@ -6,7 +6,6 @@
 #include "opentelemetry/exporters/zipkin/zipkin_exporter_factory.h"
 #include "opentelemetry/exporters/zipkin/zipkin_exporter_options.h"
 #include "opentelemetry/nostd/shared_ptr.h"
-#include "opentelemetry/sdk/trace/simple_processor_factory.h"
 #include "opentelemetry/sdk/trace/tracer_provider_factory.h"
 #include "opentelemetry/trace/propagation/http_trace_context.h"
 #include "opentelemetry/trace/provider.h"
@@ -22,10 +21,14 @@
 #include <string>
 #include <memory>
 #include <chrono>
+#include <cstdlib>
 #include <thread>
 #include <mutex>
 #include <iostream>
 
+#include "batch_span_processor.h"
+#include "trace_sampler.h"
+
 namespace trace     = opentelemetry::trace;
 namespace trace_sdk = opentelemetry::sdk::trace;
 namespace zipkin    = opentelemetry::exporter::zipkin;
@@ -66,6 +69,72 @@ public:
     }
 };
 
+/**
+ * @brief 遥测运行参数
+ */
+struct TelemetryOptions {
+    BatchSpanOptions batch;
+    SamplerOptions sampler;
+
+    /**
+     * @brief 从OpenTelemetry标准环境变量读取参数，未设置的保持默认值
+     * 批量导出：OTEL_BSP_MAX_QUEUE_SIZE、OTEL_BSP_MAX_EXPORT_BATCH_SIZE、OTEL_BSP_SCHEDULE_DELAY（毫秒）
+     * 采样：OTEL_TRACES_SAMPLER（always_on、always_off、traceidratio及其parentbased_前缀形式）、
+     * OTEL_TRACES_SAMPLER_ARG（比例）、CHAT_TRACES_MAX_PER_SECOND（每秒采样上限）
+     */
+    static TelemetryOptions FromEnvironment() {
+        TelemetryOptions options;
+        options.batch.max_queue_size = GetEnvNumber("OTEL_BSP_MAX_QUEUE_SIZE", options.batch.max_queue_size);
+        options.batch.max_export_batch_size =
+            GetEnvNumber("OTEL_BSP_MAX_EXPORT_BATCH_SIZE", options.batch.max_export_batch_size);
+        options.batch.flush_interval = std::chrono::milliseconds(
+            GetEnvNumber("OTEL_BSP_SCHEDULE_DELAY", options.batch.flush_interval.count()));
+
+        std::string sampler = GetEnvString("OTEL_TRACES_SAMPLER");
+        const std::string parent_prefix = "parentbased_";
+        if (!sampler.empty()) {
+            options.sampler.parent_based = sampler.compare(0, parent_prefix.size(), parent_prefix) == 0;
+            if (options.sampler.parent_based) {
+                sampler = sampler.substr(parent_prefix.size());
+            }
+        }
+        if (sampler == "always_off") {
+            options.sampler.ratio = 0.0;
+        } else if (sampler == "traceidratio") {
+            options.sampler.ratio = GetEnvDouble("OTEL_TRACES_SAMPLER_ARG", 1.0);
+        }
+        options.sampler.max_traces_per_second =
+            GetEnvDouble("CHAT_TRACES_MAX_PER_SECOND", options.sampler.max_traces_per_second);
+        return options;
+    }
+
+private:
+    static std::string GetEnvString(const char* name) {
+        const char* value = std::getenv(name);
+        return value != nullptr ? std::string(value) : std::string();
+    }
+
+    static double GetEnvDouble(const char* name, double default_value) {
+        const char* value = std::getenv(name);
+        if (value == nullptr || *value == '\0') {
+            return default_value;
+        }
+        char* end = nullptr;
+        double parsed = std::strtod(value, &end);
+        return (end != nullptr && *end == '\0') ? parsed : default_value;
+    }
+
+    static size_t GetEnvNumber(const char* name, size_t default_value) {
+        const char* value = std::getenv(name);
+        if (value == nullptr || *value == '\0') {
+            return default_value;
+        }
+        char* end = nullptr;
+        unsigned long long parsed = std::strtoull(value, &end, 10);
+        return (end != nullptr && *end == '\0') ? static_cast<size_t>(parsed) : default_value;
+    }
+};
+
 /**
  * @brief 遥测工具类，用于初始化和管理OpenTelemetry相关功能
  */
@@ -76,10 +145,12 @@ public:
      * @param service_name 服务名称
      * @param service_version 服务版本
      * @param endpoint 导出器端点地址
+     * @param options 批量导出、采样等运行参数
      */
     static void InitTelemetry(const std::string& service_name,
                              const std::string& service_version,
-                             const std::string& endpoint = GetDefaultZipkinEndpoint()) {
+                             const std::string& endpoint = GetDefaultZipkinEndpoint(),
+                             const TelemetryOptions& options = TelemetryOptions::FromEnvironment()) {
         
         // 创建资源属性
         resource::ResourceAttributes attributes = {
@@ -108,12 +179,14 @@ public:
         std::cout << "Zipkin exporter initialized successfully for " << service_name 
                  << " -> " << endpoint << std::endl;
         
-        // 创建处理器
-        auto processor = trace_sdk::SimpleSpanProcessorFactory::Create(std::move(exporter));
+        // 创建处理器：span在后台线程批量导出，导出端变慢不会阻塞请求线程
+        std::unique_ptr<trace_sdk::SpanProcessor> processor(
+            new AsyncBatchSpanProcessor(std::move(exporter), options.batch));
         
-        // 创建TracerProvider
+        // 创建TracerProvider，未被采样的span不记录属性和事件，也不会进入导出队列
         std::shared_ptr<opentelemetry::trace::TracerProvider> provider =
-                trace_sdk::TracerProviderFactory::Create(std::move(processor), std::move(resource));
+                trace_sdk::TracerProviderFactory::Create(std::move(processor), std::move(resource),
+                                                         CreateSampler(options.sampler));
         
         // 设置Trace provider
         trace::Provider::SetTracerProvider(provider);
@@ -236,6 +309,9 @@ public:
     }
     
     void AddEvent(const std::string& name, const std::map<std::string, std::string>& attributes) {
+        if (!span_->IsRecording()) {
+            return;
+        }
         // 先添加事件
         span_->AddEvent(name);
         
@@ -254,6 +330,9 @@ public:
     }
     
     void RecordException(const std::exception& exception) {
+        if (!span_->IsRecording()) {
+            return;
+        }
         span_->AddEvent("exception", {{"exception.type", typeid(exception).name()},
                                      {"exception.message", exception.what()}});
         span_->SetStatus(trace::StatusCode::kError, exception.what());
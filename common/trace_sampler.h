@@ -0,0 +1,110 @@
+#ifndef TRACE_SAMPLER_H
+#define TRACE_SAMPLER_H
+
+#include "opentelemetry/sdk/trace/sampler.h"
+#include "opentelemetry/sdk/trace/samplers/always_off_factory.h"
+#include "opentelemetry/sdk/trace/samplers/always_on_factory.h"
+#include "opentelemetry/sdk/trace/samplers/parent_factory.h"
+#include "opentelemetry/sdk/trace/samplers/trace_id_ratio_factory.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/**
+ * @brief 采样参数
+ * 入口服务（网关）按比例和每秒上限决定是否采样一条trace，下游服务默认跟随
+ * TcpTraceContext中trace_flags携带的上游决定，保证一条trace要么完整要么整体不采
+ */
+struct SamplerOptions {
+    bool parent_based = true;           // 有父span时跟随父span的采样标志
+    double ratio = 1.0;                 // 根span按trace_id采样的比例，0~1
+    double max_traces_per_second = 0;   // 根span每秒最多采样的trace数，0表示不限
+};
+
+/**
+ * @brief 限速采样器
+ * 先由委托采样器决定，再用GCRA令牌桶限制每秒采样数；桶状态是一个原子时间戳，不需要加锁。
+ * 允许最多一秒的突发
+ */
+class RateLimitingSampler : public opentelemetry::sdk::trace::Sampler {
+public:
+    RateLimitingSampler(std::shared_ptr<opentelemetry::sdk::trace::Sampler> delegate,
+                        double max_per_second)
+        : delegate_(std::move(delegate)),
+          interval_ns_(static_cast<int64_t>(1e9 / max_per_second)),
+          burst_ns_(1000000000LL),
+          theoretical_arrival_ns_(0),
+          description_("RateLimitingSampler{" + std::to_string(max_per_second) + "}") {}
+
+    opentelemetry::sdk::trace::SamplingResult ShouldSample(
+        const opentelemetry::trace::SpanContext& parent_context,
+        opentelemetry::trace::TraceId trace_id,
+        opentelemetry::nostd::string_view name,
+        opentelemetry::trace::SpanKind span_kind,
+        const opentelemetry::common::KeyValueIterable& attributes,
+        const opentelemetry::trace::SpanContextKeyValueIterable& links) noexcept override {
+        auto result = delegate_->ShouldSample(parent_context, trace_id, name, span_kind, attributes, links);
+        if (result.decision == opentelemetry::sdk::trace::Decision::RECORD_AND_SAMPLE && !TryAcquire()) {
+            result.decision = opentelemetry::sdk::trace::Decision::DROP;
+            result.attributes.reset();
+        }
+        return result;
+    }
+
+    opentelemetry::nostd::string_view GetDescription() const noexcept override {
+        return description_;
+    }
+
+private:
+    bool TryAcquire() noexcept {
+        int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        int64_t tat = theoretical_arrival_ns_.load(std::memory_order_relaxed);
+        while (true) {
+            int64_t next = (tat > now ? tat : now) + interval_ns_;
+            if (next - now > burst_ns_) {
+                return false;
+            }
+            if (theoretical_arrival_ns_.compare_exchange_weak(tat, next, std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+    }
+
+    std::shared_ptr<opentelemetry::sdk::trace::Sampler> delegate_;
+    const int64_t interval_ns_;
+    const int64_t burst_ns_;
+    std::atomic<int64_t> theoretical_arrival_ns_;
+    std::string description_;
+};
+
+/**
+ * @brief 按参数组装采样器：比例 -> 限速 -> 父span优先
+ */
+inline std::unique_ptr<opentelemetry::sdk::trace::Sampler> CreateSampler(const SamplerOptions& options) {
+    namespace trace_sdk = opentelemetry::sdk::trace;
+
+    std::unique_ptr<trace_sdk::Sampler> root;
+    if (options.ratio >= 1.0) {
+        root = trace_sdk::AlwaysOnSamplerFactory::Create();
+    } else if (options.ratio <= 0.0) {
+        root = trace_sdk::AlwaysOffSamplerFactory::Create();
+    } else {
+        root = trace_sdk::TraceIdRatioBasedSamplerFactory::Create(options.ratio);
+    }
+
+    if (options.max_traces_per_second > 0 && options.ratio > 0.0) {
+        root.reset(new RateLimitingSampler(std::shared_ptr<trace_sdk::Sampler>(std::move(root)),
+                                           options.max_traces_per_second));
+    }
+
+    if (!options.parent_based) {
+        return root;
+    }
+    return trace_sdk::ParentBasedSamplerFactory::Create(std::shared_ptr<trace_sdk::Sampler>(std::move(root)));
+}
+
+#endif // TRACE_SAMPLER_H
@@ -0,0 +1,268 @@
+#ifndef USER_CACHE_H
+#define USER_CACHE_H
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <list>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "id128.h"
+#include "models.h"
+#include "tcp_client.h"
+
+/**
+ * @brief 用户存在性缓存参数
+ */
+struct UserCacheOptions {
+    size_t capacity = 100000;                                 // 缓存的用户数上限，超出后淘汰最久未用的
+    std::chrono::milliseconds positive_ttl{60000};            // "用户存在"结果的有效期
+    std::chrono::milliseconds negative_ttl{5000};             // "用户不存在"结果的有效期，较短以便新注册用户尽快可见
+    size_t shard_count = 16;
+};
+
+/**
+ * @brief 用户校验结果缓存
+ * 消息服务、通知服务校验用户时先查本地缓存，命中时省去一次到user-service的往返。
+ * 同时缓存存在与不存在两种结果，各自有TTL；以16字节的用户ID为键哈希分片，每个分片独立加锁并按LRU淘汰。
+ * 只缓存user-service明确给出的结果，网络错误不写入缓存。
+ * 没有主动失效：user-service目前不会删除用户，缓存结果只随TTL过期
+ */
+class ValidatedUserCache {
+public:
+    explicit ValidatedUserCache(const UserCacheOptions& options = UserCacheOptions())
+        : options_(options), shards_(options.shard_count == 0 ? 1 : options.shard_count) {
+        shard_capacity_ = options_.capacity / shards_.size();
+        if (shard_capacity_ == 0) {
+            shard_capacity_ = 1;
+        }
+    }
+
+    /**
+     * @brief 查询缓存
+     * @param exists 命中时写入缓存的校验结果
+     * @return 未命中或已过期时返回false
+     */
+    bool Lookup(const chat::Id128& user_id, bool& exists) {
+        auto now = std::chrono::steady_clock::now();
+        Shard& shard = ShardFor(user_id);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(user_id);
+        if (it == shard.index.end()) {
+            return false;
+        }
+        if (it->second->expires_at <= now) {
+            shard.lru.erase(it->second);
+            shard.index.erase(it);
+            return false;
+        }
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        exists = it->second->exists;
+        return true;
+    }
+
+    /**
+     * @brief 写入校验结果
+     */
+    void Store(const chat::Id128& user_id, bool exists) {
+        auto expires_at = std::chrono::steady_clock::now() +
+                          (exists ? options_.positive_ttl : options_.negative_ttl);
+        Shard& shard = ShardFor(user_id);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(user_id);
+        if (it != shard.index.end()) {
+            it->second->exists = exists;
+            it->second->expires_at = expires_at;
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+            return;
+        }
+
+        shard.lru.push_front(Entry{user_id, exists, expires_at});
+        shard.index.emplace(user_id, shard.lru.begin());
+        while (shard.index.size() > shard_capacity_) {
+            shard.index.erase(shard.lru.back().user_id);
+            shard.lru.pop_back();
+        }
+    }
+
+    /**
+     * @brief 先查缓存，未命中时调用fetch并缓存其结果
+     * @param fetch 向user-service查询，返回用户是否存在；抛出异常表示无法确定，结果不缓存
+     */
+    template<typename Fetch>
+    bool Validate(const chat::Id128& user_id, Fetch&& fetch) {
+        bool exists = false;
+        if (Lookup(user_id, exists)) {
+            return exists;
+        }
+        exists = fetch();
+        Store(user_id, exists);
+        return exists;
+    }
+
+    /**
+     * @brief 批量校验：先查缓存，未命中的ID一次性交给fetch_many查询并缓存结果
+     * @param fetch_many 接收未命中的ID列表，返回按顺序对应的存在性；抛出异常时结果不缓存
+     * @return 与user_ids按顺序对应的存在性
+     */
+    template<typename FetchMany>
+    std::vector<bool> ValidateAll(const std::vector<chat::Id128>& user_ids, FetchMany&& fetch_many) {
+        std::vector<bool> results(user_ids.size(), false);
+        std::vector<chat::Id128> misses;
+        std::vector<size_t> miss_positions;
+        for (size_t i = 0; i < user_ids.size(); ++i) {
+            bool exists = false;
+            if (Lookup(user_ids[i], exists)) {
+                results[i] = exists;
+            } else {
+                misses.push_back(user_ids[i]);
+                miss_positions.push_back(i);
+            }
+        }
+        if (misses.empty()) {
+            return results;
+        }
+
+        std::vector<bool> fetched = fetch_many(misses);
+        if (fetched.size() != misses.size()) {
+            throw std::runtime_error("批量校验用户的结果数量不匹配");
+        }
+        for (size_t i = 0; i < misses.size(); ++i) {
+            Store(misses[i], fetched[i]);
+            results[miss_positions[i]] = fetched[i];
+        }
+        return results;
+    }
+
+private:
+    struct Entry {
+        chat::Id128 user_id;
+        bool exists;
+        std::chrono::steady_clock::time_point expires_at;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::list<Entry> lru;  // 头部为最近使用
+        std::unordered_map<chat::Id128, std::list<Entry>::iterator, chat::Id128Hash> index;
+    };
+
+    Shard& ShardFor(const chat::Id128& user_id) {
+        return shards_[chat::Id128Hash()(user_id) % shards_.size()];
+    }
+
+    UserCacheOptions options_;
+    std::vector<Shard> shards_;
+    size_t shard_capacity_;
+};
+
+/**
+ * @brief 经缓存向user-service校验用户是否存在
+ * 消息服务、通知服务共用。批量校验时缓存未命中的用户按user.get_many的上限分批查询；
+ * 旧版user-service不认识user.get_many，其错误应答无法按GetUsersResponse解码，此时该批逐个user.get
+ */
+class UserServiceValidator {
+public:
+    UserServiceValidator(const std::string& host, int port, const UserCacheOptions& options = UserCacheOptions())
+        : host_(host), port_(port), cache_(options) {}
+
+    /**
+     * @brief 校验单个用户
+     * @param id 输出解析后的用户ID；格式不正确的ID直接视为不存在
+     * @return 无法确认（如user-service不可用）时视为不存在
+     */
+    bool Validate(const std::string& user_id, chat::Id128& id) {
+        if (!chat::Id128::Parse(user_id, id)) {
+            return false;
+        }
+        try {
+            return cache_.Validate(id, [&]() {
+                return FetchUser(id);
+            });
+
+        } catch (const std::exception& e) {
+            std::cerr << "验证用户失败: " << e.what() << std::endl;
+            return false;
+        }
+    }
+
+    /**
+     * @brief 批量校验用户
+     * @return 与user_ids按顺序对应的存在性，无法确认的用户视为不存在
+     */
+    std::vector<bool> ValidateAll(const std::vector<chat::Id128>& user_ids) {
+        try {
+            return cache_.ValidateAll(user_ids, [this](const std::vector<chat::Id128>& misses) {
+                std::vector<bool> exists;
+                exists.reserve(misses.size());
+                for (size_t begin = 0; begin < misses.size(); begin += kBatchSize) {
+                    size_t end = std::min(misses.size(), begin + kBatchSize);
+                    FetchUsers(misses, begin, end, exists);
+                }
+                return exists;
+            });
+
+        } catch (const std::exception& e) {
+            std::cerr << "验证用户失败: " << e.what() << std::endl;
+            return std::vector<bool>(user_ids.size(), false);
+        }
+    }
+
+private:
+    /**
+     * @brief 以一次user.get_many查询[begin, end)范围内的用户，结果追加到exists
+     * 网络错误照常抛出；应答无法解码或不完整时退回逐个查询
+     */
+    void FetchUsers(const std::vector<chat::Id128>& user_ids, size_t begin, size_t end,
+                    std::vector<bool>& exists) {
+        chat::models::GetUsersRequest request;
+        for (size_t i = begin; i < end; ++i) {
+            request.user_ids.push_back(user_ids[i].ToString());
+        }
+
+        chat::models::GetUsersResponse response;
+        bool batched = true;
+        try {
+            response = tcp_client::SendRequest<chat::models::GetUsersRequest, chat::models::GetUsersResponse>(
+                host_, port_, "user.get_many", request);
+        } catch (const nlohmann::json::exception&) {
+            // 旧版user-service应答{"success":false,"message":"未知消息类型..."}，缺少users字段
+            batched = false;
+        }
+
+        if (!batched || !response.success || response.users.size() != end - begin) {
+            for (size_t i = begin; i < end; ++i) {
+                exists.push_back(FetchUser(user_ids[i]));
+            }
+            return;
+        }
+        for (const auto& user : response.users) {
+            exists.push_back(user.success);
+        }
+    }
+
+    /**
+     * @brief 通过user.get查询单个用户是否存在
+     */
+    bool FetchUser(const chat::Id128& user_id) {
+        chat::models::GetUserRequest request;
+        request.user_id = user_id.ToString();
+        auto response = tcp_client::SendRequest<chat::models::GetUserRequest, chat::models::UserInfo>(
+            host_, port_, "user.get", request);
+        return response.success;
+    }
+
+    std::string host_;
+    int port_;
+    ValidatedUserCache cache_;
+
+    static constexpr size_t kBatchSize = 1000;  // 单次user.get_many查询的用户数，与user-service的上限一致
+};
+
+#endif // USER_CACHE_H
@@ -0,0 +1,109 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief 有界工作线程池
+ * 队列满时TrySubmit直接返回false，由调用方决定如何降级，从而形成背压
+ */
+class WorkerPool {
+public:
+    /**
+     * @brief 构造函数
+     * @param num_threads 工作线程数
+     * @param max_queue_size 等待队列的最大长度
+     */
+    WorkerPool(size_t num_threads, size_t max_queue_size)
+        : max_queue_size_(max_queue_size), stopping_(false) {
+        if (num_threads == 0) {
+            num_threads = 1;
+        }
+        workers_.reserve(num_threads);
+        for (size_t i = 0; i < num_threads; ++i) {
+            workers_.emplace_back([this]() { WorkerLoop(); });
+        }
+    }
+
+    ~WorkerPool() {
+        Stop();
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /**
+     * @brief 提交任务
+     * @return 队列已满或线程池已停止时返回false
+     */
+    bool TrySubmit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_ || tasks_.size() >= max_queue_size_) {
+                return false;
+            }
+            tasks_.push_back(std::move(task));
+        }
+        cv_.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief 停止线程池，丢弃尚未开始的任务并等待正在执行的任务结束
+     */
+    void Stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_) {
+                return;
+            }
+            stopping_ = true;
+            tasks_.clear();
+        }
+        cv_.notify_all();
+        for (auto& worker : workers_) {
+            if (worker.joinable()) {
+                worker.join();
+            }
+        }
+    }
+
+    /**
+     * @brief 当前排队中的任务数
+     */
+    size_t QueueSize() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return tasks_.size();
+    }
+
+private:
+    void WorkerLoop() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+                if (stopping_) {
+                    return;
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+        }
+    }
+
+    size_t max_queue_size_;
+    bool stopping_;
+    std::deque<std::function<void()>> tasks_;
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+};
+
+#endif // WORKER_POOL_H
@@ -0,0 +1,586 @@
+#ifndef COLD_SEGMENT_H
+#define COLD_SEGMENT_H
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../common/id128.h"
+#include "../common/models.h"
+#include "stored_message.h"
+
+/**
+ * @brief 冷消息段：按列存储的不可变消息文件，通过mmap只读访问
+ * 文件布局（小端，各区按8字节对齐）：
+ *   文件头 | 时间戳列 | 发送者/接收者字典编码列 | 消息类型字典编码列 | 已读标记列 |
+ *   消息ID列（16字节） | 内容（偏移+数据） | 用户ID字典（16字节，有序） | 消息类型字典 |
+ *   按用户的行号倒排表 | 会话键及其行号倒排表 | 按消息ID排序的行号
+ * 行按(时间戳, 消息ID)排序，倒排表中的行号也保持这一顺序，分页查询在倒排表上二分。
+ * 除已读标记列外内容不再修改；已读标记通过共享映射原地写回，由WAL保证落盘前的持久性
+ */
+class ColdSegment {
+public:
+    /**
+     * @brief 某个用户或会话在本段中的行号（按时间升序）
+     */
+    struct Postings {
+        const uint32_t* rows = nullptr;
+        size_t size = 0;
+    };
+
+    ~ColdSegment() {
+        if (base_ != nullptr) {
+            munmap(base_, size_);
+        }
+    }
+
+    ColdSegment(const ColdSegment&) = delete;
+    ColdSegment& operator=(const ColdSegment&) = delete;
+
+    /**
+     * @brief 把一批消息写成段文件：先写临时文件并落盘，再原子改名并把目录落盘
+     * @throws std::runtime_error 写文件失败
+     */
+    static void Write(const std::string& path, std::vector<StoredMessage> messages) {
+        std::sort(messages.begin(), messages.end(), [](const StoredMessage& a, const StoredMessage& b) {
+            return MessageOrderLess(a.timestamp, a.message_id, b.timestamp, b.message_id);
+        });
+        auto content = Build(messages);
+
+        std::string tmp_path = path + ".tmp";
+        int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            throw std::runtime_error("创建冷消息段失败: " + tmp_path);
+        }
+        size_t written = 0;
+        while (written < content.size()) {
+            ssize_t n = write(fd, content.data() + written, content.size() - written);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                close(fd);
+                unlink(tmp_path.c_str());
+                throw std::runtime_error("写入冷消息段失败: " + tmp_path);
+            }
+            written += static_cast<size_t>(n);
+        }
+        if (fsync(fd) < 0) {
+            close(fd);
+            unlink(tmp_path.c_str());
+            throw std::runtime_error("冷消息段落盘失败: " + tmp_path);
+        }
+        close(fd);
+        if (rename(tmp_path.c_str(), path.c_str()) < 0) {
+            unlink(tmp_path.c_str());
+            throw std::runtime_error("冷消息段改名失败: " + path);
+        }
+
+        // 改名后的目录项也要落盘，否则崩溃后段文件可能不可见，而对应的WAL段已被删除；
+        // 落盘失败时删除段文件，消息仍只在热层和WAL中，由调用方稍后重试
+        size_t slash = path.find_last_of('/');
+        std::string directory = slash == std::string::npos ? "." : path.substr(0, slash + 1);
+        int dir_fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dir_fd < 0 || fsync(dir_fd) < 0) {
+            if (dir_fd >= 0) {
+                close(dir_fd);
+            }
+            unlink(path.c_str());
+            throw std::runtime_error("冷消息段目录落盘失败: " + path);
+        }
+        close(dir_fd);
+    }
+
+    /**
+     * @brief 映射已有的段文件
+     * @throws std::runtime_error 文件无法映射或格式不正确
+     */
+    static std::unique_ptr<ColdSegment> Open(const std::string& path) {
+        int fd = open(path.c_str(), O_RDWR | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::runtime_error("打开冷消息段失败: " + path);
+        }
+        struct stat st;
+        if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(Header)) {
+            close(fd);
+            throw std::runtime_error("冷消息段不完整: " + path);
+        }
+        size_t size = static_cast<size_t>(st.st_size);
+        void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (base == MAP_FAILED) {
+            throw std::runtime_error("映射冷消息段失败: " + path);
+        }
+
+        std::unique_ptr<ColdSegment> segment(new ColdSegment(static_cast<uint8_t*>(base), size));
+        if (!segment->Validate()) {
+            throw std::runtime_error("冷消息段格式错误: " + path);
+        }
+        return segment;
+    }
+
+    size_t RowCount() const {
+        return header_->row_count;
+    }
+
+    int64_t Timestamp(uint32_t row) const {
+        return Column<int64_t>(kTimestamps)[row];
+    }
+
+    const chat::Id128& MessageId(uint32_t row) const {
+        return Column<chat::Id128>(kIds)[row];
+    }
+
+    const chat::Id128& Sender(uint32_t row) const {
+        return Column<chat::Id128>(kUsers)[Column<uint32_t>(kSenders)[row]];
+    }
+
+    const chat::Id128& Receiver(uint32_t row) const {
+        return Column<chat::Id128>(kUsers)[Column<uint32_t>(kReceivers)[row]];
+    }
+
+    std::string_view MessageType(uint32_t row) const {
+        return Blob(kTypeOffsets, kTypeBlob, Column<uint32_t>(kTypes)[row]);
+    }
+
+    std::string_view Content(uint32_t row) const {
+        return Blob(kContentOffsets, kContentBlob, row);
+    }
+
+    bool IsRead(uint32_t row) const {
+        return Column<uint8_t>(kRead)[row] != 0;
+    }
+
+    /**
+     * @brief 原地写入已读标记
+     */
+    void SetRead(uint32_t row) {
+        MutableColumn<uint8_t>(kRead)[row] = 1;
+    }
+
+    /**
+     * @brief 把原地修改的已读标记写回磁盘
+     */
+    bool Flush() {
+        return msync(base_, size_, MS_SYNC) == 0;
+    }
+
+    /**
+     * @brief 从映射的列中组装出消息对象
+     */
+    chat::models::Message ToMessage(uint32_t row) const {
+        chat::models::Message message;
+        message.message_id = MessageId(row).ToString();
+        message.sender_id = Sender(row).ToString();
+        message.receiver_id = Receiver(row).ToString();
+        message.content = std::string(Content(row));
+        message.message_type = std::string(MessageType(row));
+        message.is_read = IsRead(row);
+        message.timestamp = Timestamp(row);
+        return message;
+    }
+
+    /**
+     * @brief 按消息ID查找行号
+     */
+    bool FindRow(const chat::Id128& message_id, uint32_t& row) const {
+        const uint32_t* order = Column<uint32_t>(kIdOrder);
+        const uint32_t* end = order + header_->row_count;
+        const uint32_t* it = std::lower_bound(order, end, message_id, [this](uint32_t r, const chat::Id128& id) {
+            return MessageId(r) < id;
+        });
+        if (it == end || MessageId(*it) != message_id) {
+            return false;
+        }
+        row = *it;
+        return true;
+    }
+
+    /**
+     * @brief 用户收发的全部消息
+     */
+    Postings UserPostings(const chat::Id128& user_id) const {
+        uint32_t code;
+        if (!FindUser(user_id, code)) {
+            return Postings();
+        }
+        return PostingsAt(kUserPostingOffsets, kUserPostings, code);
+    }
+
+    /**
+     * @brief 两个用户之间的会话消息
+     */
+    Postings ConversationPostings(const chat::Id128& user_a, const chat::Id128& user_b) const {
+        uint32_t code_a;
+        uint32_t code_b;
+        if (!FindUser(user_a, code_a) || !FindUser(user_b, code_b)) {
+            return Postings();
+        }
+        ConversationKey key{std::min(code_a, code_b), std::max(code_a, code_b)};
+        const ConversationKey* keys = Column<ConversationKey>(kConversationKeys);
+        const ConversationKey* end = keys + header_->conversation_count;
+        const ConversationKey* it = std::lower_bound(keys, end, key);
+        if (it == end || !(*it == key)) {
+            return Postings();
+        }
+        return PostingsAt(kConversationPostingOffsets, kConversationPostings, static_cast<uint32_t>(it - keys));
+    }
+
+    /**
+     * @brief 倒排表中排在游标之前的行数（游标未设置时为全部）
+     */
+    size_t CountBefore(const Postings& postings, const MessageCursor& cursor) const {
+        if (!cursor.IsSet()) {
+            return postings.size;
+        }
+        const uint32_t* end = postings.rows + postings.size;
+        return static_cast<size_t>(std::partition_point(postings.rows, end, [this, &cursor](uint32_t row) {
+            return cursor.IsBefore(Timestamp(row), MessageId(row));
+        }) - postings.rows);
+    }
+
+private:
+    enum Section : uint32_t {
+        kTimestamps,
+        kSenders,
+        kReceivers,
+        kTypes,
+        kRead,
+        kIds,
+        kContentOffsets,
+        kContentBlob,
+        kUsers,
+        kTypeOffsets,
+        kTypeBlob,
+        kUserPostingOffsets,
+        kUserPostings,
+        kConversationKeys,
+        kConversationPostingOffsets,
+        kConversationPostings,
+        kIdOrder,
+        kSectionCount
+    };
+
+    static constexpr char kMagic[8] = {'M', 'S', 'G', 'C', 'O', 'L', 'D', '2'};
+
+    struct Header {
+        char magic[8];
+        uint32_t row_count;
+        uint32_t user_count;
+        uint32_t type_count;
+        uint32_t conversation_count;
+        uint64_t sections[kSectionCount + 1];  // 各区起始偏移，最后一项为文件大小
+    };
+
+    struct ConversationKey {
+        uint32_t low;
+        uint32_t high;
+
+        bool operator<(const ConversationKey& other) const {
+            return low != other.low ? low < other.low : high < other.high;
+        }
+        bool operator==(const ConversationKey& other) const {
+            return low == other.low && high == other.high;
+        }
+    };
+
+    ColdSegment(uint8_t* base, size_t size)
+        : base_(base), size_(size), header_(reinterpret_cast<const Header*>(base)) {}
+
+    template<typename T>
+    const T* Column(Section section) const {
+        return reinterpret_cast<const T*>(base_ + header_->sections[section]);
+    }
+
+    template<typename T>
+    T* MutableColumn(Section section) {
+        return reinterpret_cast<T*>(base_ + header_->sections[section]);
+    }
+
+    std::string_view Blob(Section offsets, Section blob, uint32_t index) const {
+        const uint64_t* offset = Column<uint64_t>(offsets);
+        return std::string_view(reinterpret_cast<const char*>(base_ + header_->sections[blob] + offset[index]),
+                                offset[index + 1] - offset[index]);
+    }
+
+    Postings PostingsAt(Section offsets, Section rows, uint32_t index) const {
+        const uint64_t* offset = Column<uint64_t>(offsets);
+        Postings postings;
+        postings.rows = Column<uint32_t>(rows) + offset[index];
+        postings.size = offset[index + 1] - offset[index];
+        return postings;
+    }
+
+    bool FindUser(const chat::Id128& user_id, uint32_t& code) const {
+        const chat::Id128* users = Column<chat::Id128>(kUsers);
+        const chat::Id128* end = users + header_->user_count;
+        const chat::Id128* it = std::lower_bound(users, end, user_id);
+        if (it == end || *it != user_id) {
+            return false;
+        }
+        code = static_cast<uint32_t>(it - users);
+        return true;
+    }
+
+    /**
+     * @brief 校验文件头、各区大小以及所有在读取时用作下标或偏移的值，映射损坏的文件时拒绝使用
+     * 读取路径不再做边界检查，任何越界的编码、偏移或行号都必须在这里被拒绝
+     */
+    bool Validate() const {
+        if (std::memcmp(header_->magic, kMagic, sizeof(kMagic)) != 0 ||
+            header_->sections[kSectionCount] != size_) {
+            return false;
+        }
+        uint64_t previous = sizeof(Header);
+        for (uint32_t i = 0; i <= kSectionCount; ++i) {
+            if (header_->sections[i] < previous || header_->sections[i] > size_ || header_->sections[i] % 8 != 0) {
+                return false;
+            }
+            previous = header_->sections[i];
+        }
+
+        uint64_t rows = header_->row_count;
+        uint64_t users = header_->user_count;
+        uint64_t types = header_->type_count;
+        uint64_t conversations = header_->conversation_count;
+        auto section_size = [this](Section s) { return header_->sections[s + 1] - header_->sections[s]; };
+        if (section_size(kTimestamps) < rows * 8 ||
+            section_size(kSenders) < rows * 4 ||
+            section_size(kReceivers) < rows * 4 ||
+            section_size(kTypes) < rows * 4 ||
+            section_size(kRead) < rows ||
+            section_size(kIds) < rows * sizeof(chat::Id128) ||
+            section_size(kContentOffsets) < (rows + 1) * 8 ||
+            section_size(kUsers) < users * sizeof(chat::Id128) ||
+            section_size(kTypeOffsets) < (types + 1) * 8 ||
+            section_size(kUserPostingOffsets) < (users + 1) * 8 ||
+            section_size(kConversationKeys) < conversations * sizeof(ConversationKey) ||
+            section_size(kConversationPostingOffsets) < (conversations + 1) * 8 ||
+            section_size(kIdOrder) < rows * 4) {
+            return false;
+        }
+
+        // 字典编码
+        if (!AllBelow(kSenders, rows, users) || !AllBelow(kReceivers, rows, users) ||
+            !AllBelow(kTypes, rows, types) || !AllBelow(kIdOrder, rows, rows)) {
+            return false;
+        }
+        const ConversationKey* keys = Column<ConversationKey>(kConversationKeys);
+        for (uint64_t i = 0; i < conversations; ++i) {
+            if (keys[i].low >= users || keys[i].high >= users) {
+                return false;
+            }
+        }
+
+        // 偏移表单调且不超出数据区，倒排表中的行号小于行数
+        return ValidOffsets(kContentOffsets, rows, section_size(kContentBlob)) &&
+               ValidOffsets(kTypeOffsets, types, section_size(kTypeBlob)) &&
+               ValidOffsets(kUserPostingOffsets, users, section_size(kUserPostings) / 4) &&
+               ValidOffsets(kConversationPostingOffsets, conversations, section_size(kConversationPostings) / 4) &&
+               AllBelow(kUserPostings, Column<uint64_t>(kUserPostingOffsets)[users], rows) &&
+               AllBelow(kConversationPostings, Column<uint64_t>(kConversationPostingOffsets)[conversations], rows);
+    }
+
+    /**
+     * @brief uint32列的前count项是否都小于limit
+     */
+    bool AllBelow(Section section, uint64_t count, uint64_t limit) const {
+        const uint32_t* values = Column<uint32_t>(section);
+        for (uint64_t i = 0; i < count; ++i) {
+            if (values[i] >= limit) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief count+1项的偏移表是否从0开始、单调不减且最后一项不超过limit
+     */
+    bool ValidOffsets(Section section, uint64_t count, uint64_t limit) const {
+        const uint64_t* offsets = Column<uint64_t>(section);
+        if (offsets[0] != 0) {
+            return false;
+        }
+        for (uint64_t i = 0; i < count; ++i) {
+            if (offsets[i + 1] < offsets[i]) {
+                return false;
+            }
+        }
+        return offsets[count] <= limit;
+    }
+
+    /**
+     * @brief 按列构建段文件内容，messages已按时间排序
+     */
+    static std::vector<uint8_t> Build(const std::vector<StoredMessage>& messages) {
+        uint32_t rows = static_cast<uint32_t>(messages.size());
+
+        // 字典按值排序，编码顺序即值的顺序，查找时可二分
+        std::vector<chat::Id128> users;
+        std::vector<std::string_view> types;
+        for (const auto& message : messages) {
+            users.push_back(message.sender_id);
+            users.push_back(message.receiver_id);
+            types.push_back(message.message_type);
+        }
+        SortUnique(users);
+        SortUnique(types);
+        auto code_of = [](const auto& dictionary, const auto& value) {
+            return static_cast<uint32_t>(std::lower_bound(dictionary.begin(), dictionary.end(), value) -
+                                         dictionary.begin());
+        };
+
+        std::vector<int64_t> timestamps(rows);
+        std::vector<chat::Id128> ids(rows);
+        std::vector<uint32_t> senders(rows);
+        std::vector<uint32_t> receivers(rows);
+        std::vector<uint32_t> message_types(rows);
+        std::vector<uint8_t> read(rows);
+        std::vector<std::vector<uint32_t>> user_rows(users.size());
+        std::vector<std::pair<ConversationKey, uint32_t>> conversation_rows;
+        conversation_rows.reserve(rows);
+        for (uint32_t row = 0; row < rows; ++row) {
+            const auto& message = messages[row];
+            timestamps[row] = message.timestamp;
+            ids[row] = message.message_id;
+            senders[row] = code_of(users, message.sender_id);
+            receivers[row] = code_of(users, message.receiver_id);
+            message_types[row] = code_of(types, message.message_type);
+            read[row] = message.is_read ? 1 : 0;
+            user_rows[senders[row]].push_back(row);
+            if (receivers[row] != senders[row]) {
+                user_rows[receivers[row]].push_back(row);
+            }
+            conversation_rows.push_back({ConversationKey{std::min(senders[row], receivers[row]),
+                                                         std::max(senders[row], receivers[row])}, row});
+        }
+
+        // 会话倒排表：按键稳定排序后同一会话的行号仍保持时间顺序
+        std::stable_sort(conversation_rows.begin(), conversation_rows.end(),
+                         [](const std::pair<ConversationKey, uint32_t>& a,
+                            const std::pair<ConversationKey, uint32_t>& b) { return a.first < b.first; });
+        std::vector<ConversationKey> conversation_keys;
+        std::vector<uint64_t> conversation_offsets{0};
+        std::vector<uint32_t> conversation_postings;
+        for (const auto& entry : conversation_rows) {
+            if (conversation_keys.empty() || !(conversation_keys.back() == entry.first)) {
+                if (!conversation_keys.empty()) {
+                    conversation_offsets.push_back(conversation_postings.size());
+                }
+                conversation_keys.push_back(entry.first);
+            }
+            conversation_postings.push_back(entry.second);
+        }
+        conversation_offsets.push_back(conversation_postings.size());
+        if (conversation_keys.empty()) {
+            conversation_offsets.resize(1);
+        }
+
+        std::vector<uint64_t> user_offsets{0};
+        std::vector<uint32_t> user_postings;
+        for (const auto& list : user_rows) {
+            user_postings.insert(user_postings.end(), list.begin(), list.end());
+            user_offsets.push_back(user_postings.size());
+        }
+
+        std::vector<uint32_t> id_order(rows);
+        for (uint32_t row = 0; row < rows; ++row) {
+            id_order[row] = row;
+        }
+        std::sort(id_order.begin(), id_order.end(), [&ids](uint32_t a, uint32_t b) {
+            return ids[a] < ids[b];
+        });
+
+        std::vector<uint8_t> out(sizeof(Header));
+        Header header{};
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.row_count = rows;
+        header.user_count = static_cast<uint32_t>(users.size());
+        header.type_count = static_cast<uint32_t>(types.size());
+        header.conversation_count = static_cast<uint32_t>(conversation_keys.size());
+
+        auto begin_section = [&out, &header](Section section) {
+            out.resize((out.size() + 7) & ~size_t(7));
+            header.sections[section] = out.size();
+        };
+        auto put = [&out](const void* data, size_t size) {
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+            out.insert(out.end(), bytes, bytes + size);
+        };
+        auto put_vector = [&put](const auto& values) {
+            put(values.data(), values.size() * sizeof(values[0]));
+        };
+        auto put_strings = [&](Section offsets_section, Section blob_section, size_t count, auto&& get) {
+            std::vector<uint64_t> offsets{0};
+            std::string blob;
+            for (size_t i = 0; i < count; ++i) {
+                std::string_view value = get(i);
+                blob.append(value.data(), value.size());
+                offsets.push_back(blob.size());
+            }
+            begin_section(offsets_section);
+            put_vector(offsets);
+            begin_section(blob_section);
+            put(blob.data(), blob.size());
+        };
+
+        begin_section(kTimestamps);
+        put_vector(timestamps);
+        begin_section(kSenders);
+        put_vector(senders);
+        begin_section(kReceivers);
+        put_vector(receivers);
+        begin_section(kTypes);
+        put_vector(message_types);
+        begin_section(kRead);
+        put_vector(read);
+        begin_section(kIds);
+        put_vector(ids);
+        put_strings(kContentOffsets, kContentBlob, rows,
+                    [&messages](size_t i) { return std::string_view(messages[i].content); });
+        begin_section(kUsers);
+        put_vector(users);
+        put_strings(kTypeOffsets, kTypeBlob, types.size(), [&types](size_t i) { return types[i]; });
+        begin_section(kUserPostingOffsets);
+        put_vector(user_offsets);
+        begin_section(kUserPostings);
+        put_vector(user_postings);
+        begin_section(kConversationKeys);
+        put_vector(conversation_keys);
+        begin_section(kConversationPostingOffsets);
+        put_vector(conversation_offsets);
+        begin_section(kConversationPostings);
+        put_vector(conversation_postings);
+        begin_section(kIdOrder);
+        put_vector(id_order);
+        begin_section(kSectionCount);
+
+        std::memcpy(out.data(), &header, sizeof(header));
+        return out;
+    }
+
+    template<typename T>
+    static void SortUnique(std::vector<T>& values) {
+        std::sort(values.begin(), values.end());
+        values.erase(std::unique(values.begin(), values.end()), values.end());
+    }
+
+    uint8_t* base_;
+    size_t size_;
+    const Header* header_;
+};
+
+#endif // COLD_SEGMENT_H
@@ -1,4 +1,5 @@
 #include "tcp_message_service.h"
+#include <algorithm>
 #include <iostream>
 #include <signal.h>
 
@@ -28,6 +29,8 @@ int main(int argc, char* argv[]) {
         int port = 8082;
         std::string user_service_host = "127.0.0.1";
         int user_service_port = 8081;
+        MessageStoreOptions store_options;
+        NotificationDispatcherOptions notification_options;
         
         if (argc >= 2) {
             host = argv[1];
@@ -41,14 +44,37 @@ int main(int argc, char* argv[]) {
         if (argc >= 5) {
             user_service_port = std::stoi(argv[4]);
         }
+        if (argc >= 6) {
+            store_options.wal.directory = argv[5];
+        }
+        if (argc >= 7) {
+            store_options.hot_message_limit = std::stoul(argv[6]);
+            store_options.segment_rows = std::max<size_t>(store_options.hot_message_limit / 2, 1);
+        }
+        if (argc >= 8) {
+            // 通知服务地址，"-"表示不发送新消息通知
+            notification_options.enabled = std::string(argv[7]) != "-";
+            notification_options.host = argv[7];
+        }
+        if (argc >= 9) {
+            notification_options.port = std::stoi(argv[8]);
+        }
         
         std::cout << "启动参数:" << std::endl;
         std::cout << "- 主机: " << host << std::endl;
         std::cout << "- 端口: " << port << std::endl;
         std::cout << "- 用户服务: " << user_service_host << ":" << user_service_port << std::endl;
+        std::cout << "- 数据目录: " << store_options.wal.directory << std::endl;
+        std::cout << "- 热层消息上限: " << store_options.hot_message_limit << std::endl;
+        if (notification_options.enabled) {
+            std::cout << "- 新消息通知: " << notification_options.host << ":" << notification_options.port << std::endl;
+        } else {
+            std::cout << "- 新消息通知: 关闭" << std::endl;
+        }
         
         // 创建服务实例
-        g_service = std::make_unique<TcpMessageService>(host, port, user_service_host, user_service_port);
+        g_service = std::make_unique<TcpMessageService>(host, port, user_service_host, user_service_port,
+                                                        store_options, notification_options);
         
         // 启动服务
         g_service->Start();
@@ -58,6 +84,7 @@ int main(int argc, char* argv[]) {
         std::cout << "- message.send: 发送消息" << std::endl;
         std::cout << "- message.get: 获取消息列表" << std::endl;
         std::cout << "- message.mark_read: 标记消息已读" << std::endl;
+        std::cout << "- message.unread_counts: 获取未读消息数" << std::endl;
         std::cout << "按 Ctrl+C 停止服务" << std::endl;
         
         // 等待服务结束
@@ -0,0 +1,91 @@
+#ifndef MESSAGE_INDEX_H
+#define MESSAGE_INDEX_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "stored_message.h"
+
+/**
+ * @brief 按时间排序的消息索引
+ * 消息按发送顺序追加，时间戳天然递增，追加是O(1)；系统时钟回拨或同一毫秒内的ID乱序时退化为有序插入。
+ * 分页查询用二分定位游标，再从游标向前取最多limit条，整体O(log n + limit)，不排序也不复制历史。
+ * 每条索引项带消息的WAL序号，消息被压缩进冷消息段后按序号从索引中移除
+ */
+class TimeOrderedIndex {
+public:
+    /**
+     * @brief 一次分页查询的结果
+     */
+    struct Page {
+        std::vector<const StoredMessage*> messages;  // 最新的在前
+        bool has_more = false;                       // 游标之前是否还有更早的消息
+    };
+
+    void Append(const StoredMessage* message, uint64_t sequence) {
+        Entry entry{message->timestamp, sequence, message};
+        if (entries_.empty() || Less(entries_.back(), entry)) {
+            entries_.push_back(entry);
+            return;
+        }
+        // 按(时间戳, 消息ID)插到第一条排在它之后的索引项前面
+        auto it = std::upper_bound(entries_.begin(), entries_.end(), entry,
+                                   [](const Entry& a, const Entry& b) { return Less(a, b); });
+        entries_.insert(it, entry);
+    }
+
+    /**
+     * @brief 取排在游标之前的最新limit条消息
+     * @param cursor 未设置时从最新一条开始
+     * @param limit 最多返回条数，<=0表示不限
+     */
+    Page Before(const MessageCursor& cursor, int32_t limit) const {
+        auto end = entries_.end();
+        if (cursor.IsSet()) {
+            end = std::partition_point(entries_.begin(), entries_.end(), [&cursor](const Entry& e) {
+                return cursor.IsBefore(e.timestamp, e.message->message_id);
+            });
+        }
+
+        size_t available = static_cast<size_t>(end - entries_.begin());
+        size_t count = (limit > 0 && static_cast<size_t>(limit) < available) ? static_cast<size_t>(limit) : available;
+
+        Page page;
+        page.has_more = count < available;
+        page.messages.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            page.messages.push_back((end - 1 - i)->message);
+        }
+        return page;
+    }
+
+    /**
+     * @brief 移除WAL序号不大于sequence的索引项
+     */
+    void DropThrough(uint64_t sequence) {
+        entries_.erase(std::remove_if(entries_.begin(), entries_.end(),
+                                      [sequence](const Entry& e) { return e.sequence <= sequence; }),
+                       entries_.end());
+    }
+
+    size_t Size() const {
+        return entries_.size();
+    }
+
+private:
+    struct Entry {
+        int64_t timestamp;
+        uint64_t sequence;
+        const StoredMessage* message;
+    };
+
+    // 时间戳不同时不必访问消息本身
+    static bool Less(const Entry& a, const Entry& b) {
+        return MessageOrderLess(a.timestamp, a.message->message_id, b.timestamp, b.message->message_id);
+    }
+
+    std::vector<Entry> entries_;
+};
+
+#endif // MESSAGE_INDEX_H
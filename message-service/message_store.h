@@ -0,0 +1,636 @@
+#ifndef MESSAGE_STORE_H
+#define MESSAGE_STORE_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../common/binary_codec.h"
+#include "../common/id128.h"
+#include "../common/models.h"
+#include "cold_segment.h"
+#include "message_index.h"
+#include "message_wal.h"
+#include "stored_message.h"
+
+/**
+ * @brief 消息存储参数
+ */
+struct MessageStoreOptions {
+    WalOptions wal;                       // WAL与冷消息段共用wal.directory
+    size_t hot_message_limit = 100000;    // 内存中保留的最近消息数，超过后把最早的一批压缩成冷消息段
+    size_t segment_rows = 50000;          // 每个冷消息段包含的消息数
+};
+
+/**
+ * @brief 分层消息存储
+ * 最近的消息以紧凑记录留在内存（热层），由按时间排序、以16字节ID为键的索引支撑查询；热层超过上限后，
+ * 后台线程把最早的一批写成按列存储的冷消息段并mmap，随后从热层和WAL中移除。
+ * 常驻内存只与热层大小有关，历史消息的读取直接访问映射的列，由操作系统页缓存按需换入换出。
+ * 所有修改先写WAL，等组提交落盘后才在内存中生效并返回
+ */
+class TieredMessageStore {
+public:
+    /**
+     * @brief 一页查询结果，最新的在前
+     */
+    struct Page {
+        std::vector<chat::models::Message> messages;
+        bool has_more = false;
+    };
+
+    enum class MarkReadResult {
+        kMarked,
+        kNotFound,
+        kForbidden
+    };
+
+    /**
+     * @brief 用户的未读消息数
+     */
+    struct UnreadSummary {
+        uint64_t total = 0;
+        std::vector<std::pair<chat::Id128, uint64_t>> by_sender;  // 按发送者（即会话对方）统计，只含未读数大于0的会话
+    };
+
+    explicit TieredMessageStore(const MessageStoreOptions& options)
+        : options_(options), wal_(options.wal), stopping_(false) {
+        if (options_.segment_rows == 0) {
+            options_.segment_rows = 1;
+        }
+    }
+
+    ~TieredMessageStore() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        compact_cv_.notify_one();
+        if (compactor_.joinable()) {
+            compactor_.join();
+        }
+        wal_.Close();
+    }
+
+    TieredMessageStore(const TieredMessageStore&) = delete;
+    TieredMessageStore& operator=(const TieredMessageStore&) = delete;
+
+    /**
+     * @brief 映射冷消息段、回放WAL并启动压缩线程，启动时调用一次
+     * @throws std::runtime_error 数据文件无法读取
+     */
+    void Open() {
+        const std::string& directory = options_.wal.directory;
+        if (mkdir(directory.c_str(), 0755) < 0 && errno != EEXIST) {
+            throw std::runtime_error("创建数据目录失败: " + directory);
+        }
+        LoadColdSegments();
+
+        size_t recovered = 0;
+        wal_.Open([this, &recovered](uint64_t sequence, uint8_t type, const uint8_t* data, size_t size) {
+            ReplayRecord(sequence, type, data, size);
+            ++recovered;
+        });
+
+        size_t cold_rows = 0;
+        for (const auto& segment : cold_) {
+            cold_rows += segment->RowCount();
+        }
+        std::cout << "消息存储: " << cold_.size() << " 个冷消息段共 " << cold_rows
+                  << " 条消息，从WAL恢复 " << recovered << " 条记录，热层 " << hot_.size() << " 条消息" << std::endl;
+
+        compactor_ = std::thread([this]() { CompactLoop(); });
+    }
+
+    /**
+     * @brief 写入一条新消息，落盘后才对查询可见并返回
+     * @throws std::runtime_error 写WAL失败，消息不会出现在热层中
+     */
+    void Add(const StoredMessage& message) {
+        uint64_t sequence;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            // 在锁内追加WAL，序号顺序即热层中的顺序
+            sequence = wal_.Append(kWalMessage, binary_codec::Encode(message.ToMessage()));
+            unpublished_.emplace(sequence, message);
+        }
+
+        // 等待组提交落盘后再发布
+        try {
+            wal_.WaitDurable(sequence);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            unpublished_.erase(sequence);
+            throw;
+        }
+
+        bool compact;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            PublishDurable(sequence);
+            compact = hot_.size() > options_.hot_message_limit;
+        }
+        if (compact) {
+            compact_cv_.notify_one();
+        }
+    }
+
+    /**
+     * @brief 取排在游标之前的最新limit条消息
+     * 并发发送时时间戳与WAL顺序不完全一致，热层与各冷消息段的时间范围可能交叠，
+     * 因此从每一层各取排在游标之前最新的至多limit条，按(时间戳, 消息ID)合并后再截取
+     * @param other_user_id 为空ID时查询用户的全部消息，否则查询两人之间的会话
+     */
+    Page Get(const chat::Id128& user_id, const chat::Id128& other_user_id,
+             const MessageCursor& cursor, int32_t limit) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t wanted = limit > 0 ? static_cast<size_t>(limit) : std::numeric_limits<size_t>::max();
+        std::vector<PageCandidate> candidates;
+        bool has_more = false;
+
+        // 热层
+        const TimeOrderedIndex* index = nullptr;
+        if (!other_user_id.IsNil()) {
+            auto it = messages_by_conversation_.find(ConversationKey(user_id, other_user_id));
+            index = it != messages_by_conversation_.end() ? &it->second : nullptr;
+        } else {
+            auto it = messages_by_user_.find(user_id);
+            index = it != messages_by_user_.end() ? &it->second : nullptr;
+        }
+        if (index) {
+            auto hot_page = index->Before(cursor, limit);
+            has_more = hot_page.has_more;
+            candidates.reserve(hot_page.messages.size());
+            for (const auto* message : hot_page.messages) {
+                candidates.push_back(PageCandidate{message->timestamp, message->message_id, message, nullptr, 0});
+            }
+        }
+
+        // 冷消息段从新到旧，只取比当前第limit条更新的行
+        for (auto it = cold_.rbegin(); it != cold_.rend(); ++it) {
+            const ColdSegment& segment = **it;
+            auto postings = other_user_id.IsNil() ? segment.UserPostings(user_id)
+                                                  : segment.ConversationPostings(user_id, other_user_id);
+            size_t available = segment.CountBefore(postings, cursor);
+            size_t merged_from = candidates.size();
+            for (size_t i = 0; i < available; ++i) {
+                uint32_t row = postings.rows[available - 1 - i];
+                PageCandidate candidate{segment.Timestamp(row), segment.MessageId(row), nullptr, &segment, row};
+                if (i == wanted || (merged_from >= wanted && !candidate.Newer(candidates[wanted - 1]))) {
+                    has_more = true;
+                    break;
+                }
+                candidates.push_back(candidate);
+            }
+            if (candidates.size() == merged_from) {
+                continue;
+            }
+            // 两段各自有序，合并后保留最新的limit条
+            std::inplace_merge(candidates.begin(), candidates.begin() + merged_from, candidates.end(),
+                               [](const PageCandidate& a, const PageCandidate& b) { return a.Newer(b); });
+            if (candidates.size() > wanted) {
+                candidates.resize(wanted);
+                has_more = true;
+            }
+        }
+
+        Page page;
+        page.has_more = has_more;
+        page.messages.reserve(candidates.size());
+        for (const auto& candidate : candidates) {
+            page.messages.push_back(candidate.hot != nullptr ? candidate.hot->ToMessage()
+                                                             : candidate.segment->ToMessage(candidate.row));
+        }
+        return page;
+    }
+
+    /**
+     * @brief 取用户的未读消息数，计数随收发和标记已读增量维护，不扫描历史
+     */
+    UnreadSummary UnreadCounts(const chat::Id128& user_id) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        UnreadSummary summary;
+        auto it = unread_.find(user_id);
+        if (it == unread_.end()) {
+            return summary;
+        }
+        summary.total = it->second.total;
+        summary.by_sender.assign(it->second.by_sender.begin(), it->second.by_sender.end());
+        return summary;
+    }
+
+    /**
+     * @brief 接收者把消息标记为已读，落盘后返回
+     * @throws std::runtime_error 写WAL失败
+     */
+    MarkReadResult MarkRead(const chat::Id128& user_id, const chat::Id128& message_id) {
+        chat::models::MarkMessageReadRequest record;
+        record.user_id = user_id.ToString();
+        record.message_id = message_id.ToString();
+
+        uint64_t sequence;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            bool already_read = false;
+            MarkReadResult result = CheckMarkRead(user_id, message_id, already_read);
+            // 已读的消息不再写WAL，重复标记不必等待落盘
+            if (result != MarkReadResult::kMarked || already_read) {
+                return result;
+            }
+            sequence = wal_.Append(kWalMarkRead, binary_codec::Encode(record));
+            unapplied_marks_.insert(sequence);
+        }
+
+        // 落盘后才修改内存中的状态，写WAL失败时已读标记和未读数都保持不变
+        try {
+            wal_.WaitDurable(sequence);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            unapplied_marks_.erase(sequence);
+            throw;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            // 等待期间消息可能已被压缩进冷消息段，ApplyMarkRead两层都会查找
+            ApplyMarkRead(user_id, message_id);
+            unapplied_marks_.erase(sequence);
+        }
+        return MarkReadResult::kMarked;
+    }
+
+private:
+    // WAL记录类型写入磁盘，只能追加新值
+    static constexpr uint8_t kWalMessage = 1;
+    static constexpr uint8_t kWalMarkRead = 2;
+
+    struct HotMessage {
+        uint64_t sequence;
+        StoredMessage message;
+    };
+
+    /**
+     * @brief 分页合并时的一条候选消息，来自热层或某个冷消息段的一行
+     */
+    struct PageCandidate {
+        int64_t timestamp;
+        chat::Id128 message_id;
+        const StoredMessage* hot;
+        const ColdSegment* segment;
+        uint32_t row;
+
+        bool Newer(const PageCandidate& other) const {
+            return MessageOrderLess(other.timestamp, other.message_id, timestamp, message_id);
+        }
+    };
+
+    struct UnreadCounter {
+        uint64_t total = 0;
+        std::unordered_map<chat::Id128, uint64_t, chat::Id128Hash> by_sender;
+    };
+
+    static std::pair<chat::Id128, chat::Id128> ConversationKey(const chat::Id128& a, const chat::Id128& b) {
+        return std::make_pair(std::min(a, b), std::max(a, b));
+    }
+
+    /**
+     * @brief 存入热层并更新索引，调用方需持有mutex_
+     */
+    void StoreHot(const StoredMessage& message, uint64_t sequence) {
+        // deque两端插入删除不会使其余元素的地址失效，索引直接引用其中的消息
+        hot_.push_back(HotMessage{sequence, message});
+        const StoredMessage* stored = &hot_.back().message;
+        hot_by_id_[message.message_id] = &hot_.back();
+
+        messages_by_user_[message.sender_id].Append(stored, sequence);
+        if (message.receiver_id != message.sender_id) {
+            messages_by_user_[message.receiver_id].Append(stored, sequence);
+        }
+        messages_by_conversation_[ConversationKey(message.sender_id, message.receiver_id)].Append(stored, sequence);
+
+        if (!message.is_read) {
+            CountUnread(message.receiver_id, message.sender_id, true);
+        }
+    }
+
+    /**
+     * @brief 按序号顺序发布已落盘的消息，调用方需持有mutex_
+     * 落盘按序号前缀推进，序号不大于sequence的消息都已落盘，可能由其他写入线程先行发布
+     */
+    void PublishDurable(uint64_t sequence) {
+        while (!unpublished_.empty() && unpublished_.begin()->first <= sequence) {
+            StoreHot(unpublished_.begin()->second, unpublished_.begin()->first);
+            unpublished_.erase(unpublished_.begin());
+        }
+    }
+
+    /**
+     * @brief 接收者的未读数加一或减一，调用方需持有mutex_
+     */
+    void CountUnread(const chat::Id128& receiver_id, const chat::Id128& sender_id, bool increment) {
+        if (increment) {
+            UnreadCounter& counter = unread_[receiver_id];
+            ++counter.total;
+            ++counter.by_sender[sender_id];
+            return;
+        }
+        auto it = unread_.find(receiver_id);
+        if (it == unread_.end()) {
+            return;
+        }
+        auto sender_it = it->second.by_sender.find(sender_id);
+        if (sender_it != it->second.by_sender.end() && --sender_it->second == 0) {
+            it->second.by_sender.erase(sender_it);
+        }
+        if (--it->second.total == 0) {
+            unread_.erase(it);
+        }
+    }
+
+    /**
+     * @brief 检查消息存在且用户是其接收者，不修改状态，调用方需持有mutex_
+     * @param already_read 返回kMarked时写入消息是否已经是已读
+     */
+    MarkReadResult CheckMarkRead(const chat::Id128& user_id, const chat::Id128& message_id,
+                                 bool& already_read) const {
+        auto hot_it = hot_by_id_.find(message_id);
+        if (hot_it != hot_by_id_.end()) {
+            const StoredMessage& message = hot_it->second->message;
+            if (message.receiver_id != user_id) {
+                return MarkReadResult::kForbidden;
+            }
+            already_read = message.is_read;
+            return MarkReadResult::kMarked;
+        }
+        for (auto it = cold_.rbegin(); it != cold_.rend(); ++it) {
+            uint32_t row;
+            if ((*it)->FindRow(message_id, row)) {
+                if ((*it)->Receiver(row) != user_id) {
+                    return MarkReadResult::kForbidden;
+                }
+                already_read = (*it)->IsRead(row);
+                return MarkReadResult::kMarked;
+            }
+        }
+        return MarkReadResult::kNotFound;
+    }
+
+    /**
+     * @brief 在热层或冷消息段中标记已读，调用方需持有mutex_
+     */
+    MarkReadResult ApplyMarkRead(const chat::Id128& user_id, const chat::Id128& message_id) {
+        auto hot_it = hot_by_id_.find(message_id);
+        if (hot_it != hot_by_id_.end()) {
+            StoredMessage& message = hot_it->second->message;
+            // 只有接收者可以标记已读
+            if (message.receiver_id != user_id) {
+                return MarkReadResult::kForbidden;
+            }
+            if (!message.is_read) {
+                message.is_read = true;
+                CountUnread(message.receiver_id, message.sender_id, false);
+            }
+            return MarkReadResult::kMarked;
+        }
+
+        for (auto it = cold_.rbegin(); it != cold_.rend(); ++it) {
+            uint32_t row;
+            if ((*it)->FindRow(message_id, row)) {
+                if ((*it)->Receiver(row) != user_id) {
+                    return MarkReadResult::kForbidden;
+                }
+                if (!(*it)->IsRead(row)) {
+                    (*it)->SetRead(row);
+                    CountUnread(user_id, (*it)->Sender(row), false);
+                }
+                return MarkReadResult::kMarked;
+            }
+        }
+        return MarkReadResult::kNotFound;
+    }
+
+    /**
+     * @brief 回放一条WAL记录（启动时调用，尚未对外服务）
+     */
+    void ReplayRecord(uint64_t sequence, uint8_t type, const uint8_t* data, size_t size) {
+        if (type == kWalMessage) {
+            auto message = StoredMessage::FromMessage(binary_codec::Decode<chat::models::Message>(data, size));
+            // 压缩完成后、WAL截断前崩溃时，消息已在冷消息段中
+            if (!ColdContains(message.message_id)) {
+                StoreHot(message, sequence);
+            }
+        } else if (type == kWalMarkRead) {
+            auto request = binary_codec::Decode<chat::models::MarkMessageReadRequest>(data, size);
+            chat::Id128 user_id;
+            chat::Id128 message_id;
+            if (chat::Id128::Parse(request.user_id, user_id) && chat::Id128::Parse(request.message_id, message_id)) {
+                ApplyMarkRead(user_id, message_id);
+            }
+        } else {
+            throw std::runtime_error("未知的WAL记录类型: " + std::to_string(type));
+        }
+    }
+
+    bool ColdContains(const chat::Id128& message_id) const {
+        uint32_t row;
+        for (const auto& segment : cold_) {
+            if (segment->FindRow(message_id, row)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void LoadColdSegments() {
+        const std::string& directory = options_.wal.directory;
+        DIR* dir = opendir(directory.c_str());
+        if (dir == nullptr) {
+            throw std::runtime_error("打开数据目录失败: " + directory);
+        }
+        std::vector<std::string> names;
+        while (dirent* entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            unsigned long long first_sequence;
+            char suffix[8];
+            if (std::sscanf(name.c_str(), "cold-%20llu.%7s", &first_sequence, suffix) != 2) {
+                continue;
+            }
+            if (std::string(suffix) == "seg") {
+                names.push_back(name);
+            } else {
+                // 压缩中途退出留下的临时文件
+                unlink((directory + "/" + name).c_str());
+            }
+        }
+        closedir(dir);
+
+        // 文件名中的序号定长，按名称排序即按时间排序
+        std::sort(names.begin(), names.end());
+        for (const auto& name : names) {
+            cold_.push_back(ColdSegment::Open(directory + "/" + name));
+            // 未读计数不落盘，启动时从冷消息段的已读列和发送者/接收者列重建
+            const ColdSegment& segment = *cold_.back();
+            for (uint32_t row = 0; row < segment.RowCount(); ++row) {
+                if (!segment.IsRead(row)) {
+                    CountUnread(segment.Receiver(row), segment.Sender(row), true);
+                }
+            }
+        }
+    }
+
+    std::string ColdSegmentPath(uint64_t first_sequence) const {
+        char name[32];
+        std::snprintf(name, sizeof(name), "cold-%020llu.seg", static_cast<unsigned long long>(first_sequence));
+        return options_.wal.directory + "/" + name;
+    }
+
+    /**
+     * @brief 压缩线程：热层超过上限时把最早的一批消息写成冷消息段
+     */
+    void CompactLoop() {
+        while (true) {
+            std::vector<StoredMessage> batch;
+            uint64_t first_sequence;
+            uint64_t last_sequence;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                compact_cv_.wait(lock, [this]() {
+                    return stopping_ || hot_.size() > options_.hot_message_limit;
+                });
+                if (stopping_) {
+                    return;
+                }
+                size_t count = std::min(options_.segment_rows, hot_.size());
+                batch.reserve(count);
+                for (size_t i = 0; i < count; ++i) {
+                    batch.push_back(hot_[i].message);
+                }
+                first_sequence = hot_.front().sequence;
+                last_sequence = hot_[count - 1].sequence;
+            }
+
+            try {
+                Compact(std::move(batch), first_sequence, last_sequence);
+            } catch (const std::exception& e) {
+                // 数据仍在热层和WAL中，稍后重试
+                std::cerr << "压缩冷消息段失败: " << e.what() << std::endl;
+                std::unique_lock<std::mutex> lock(mutex_);
+                compact_cv_.wait_for(lock, std::chrono::seconds(10), [this]() { return stopping_; });
+            }
+        }
+    }
+
+    void Compact(std::vector<StoredMessage> batch, uint64_t first_sequence, uint64_t last_sequence) {
+        // 只有这批消息的收发双方和会话的索引含有要移除的项
+        std::set<chat::Id128> users;
+        std::set<std::pair<chat::Id128, chat::Id128>> conversations;
+        for (const auto& message : batch) {
+            users.insert(message.sender_id);
+            users.insert(message.receiver_id);
+            conversations.insert(ConversationKey(message.sender_id, message.receiver_id));
+        }
+
+        // 写段文件和映射都在锁外进行，不阻塞请求
+        std::string path = ColdSegmentPath(first_sequence);
+        ColdSegment::Write(path, std::move(batch));
+        auto segment = ColdSegment::Open(path);
+
+        std::vector<ColdSegment*> segments;
+        uint64_t first_hot_sequence;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            // 写段期间被标记已读的消息，把已读状态带到冷消息段
+            while (!hot_.empty() && hot_.front().sequence <= last_sequence) {
+                const StoredMessage& message = hot_.front().message;
+                uint32_t row;
+                if (message.is_read && segment->FindRow(message.message_id, row)) {
+                    segment->SetRead(row);
+                }
+                hot_by_id_.erase(message.message_id);
+                hot_.pop_front();
+            }
+            DropIndexed(messages_by_user_, users, last_sequence);
+            DropIndexed(messages_by_conversation_, conversations, last_sequence);
+
+            cold_.push_back(std::move(segment));
+            for (const auto& cold : cold_) {
+                segments.push_back(cold.get());
+            }
+            first_hot_sequence = hot_.empty() ? last_sequence + 1 : hot_.front().sequence;
+            // 尚未发布的消息和尚未应用的已读标记只在WAL中，它们所在的段不能删除
+            if (!unpublished_.empty()) {
+                first_hot_sequence = std::min(first_hot_sequence, unpublished_.begin()->first);
+            }
+            if (!unapplied_marks_.empty()) {
+                first_hot_sequence = std::min(first_hot_sequence, *unapplied_marks_.begin());
+            }
+        }
+
+        // 冷消息段上的已读标记写回磁盘后，被压缩消息所在的WAL段才可以删除
+        for (auto* cold : segments) {
+            if (!cold->Flush()) {
+                throw std::runtime_error("冷消息段落盘失败");
+            }
+        }
+        wal_.DropSegmentsBefore(first_hot_sequence);
+    }
+
+    /**
+     * @brief 从指定键的索引中移除已压缩的项，索引变空时一并删除，调用方需持有mutex_
+     */
+    template<typename Map, typename Keys>
+    static void DropIndexed(Map& indexes, const Keys& keys, uint64_t last_sequence) {
+        for (const auto& key : keys) {
+            auto it = indexes.find(key);
+            if (it == indexes.end()) {
+                continue;
+            }
+            it->second.DropThrough(last_sequence);
+            if (it->second.Size() == 0) {
+                indexes.erase(it);
+            }
+        }
+    }
+
+    MessageStoreOptions options_;
+    MessageWal wal_;
+
+    mutable std::mutex mutex_;
+    // 热层：按写入顺序保存最近的消息
+    std::deque<HotMessage> hot_;
+    std::unordered_map<chat::Id128, HotMessage*, chat::Id128Hash> hot_by_id_;
+    // 已写入WAL、等待落盘后发布到热层的消息，按序号排序
+    std::map<uint64_t, StoredMessage> unpublished_;
+    // 已写入WAL、等待落盘后应用的已读标记序号
+    std::set<uint64_t> unapplied_marks_;
+    // 按用户ID索引热层中收发的消息（按时间排序）
+    std::map<chat::Id128, TimeOrderedIndex> messages_by_user_;
+    // 按会话索引热层中的消息（用户ID对，按时间排序）
+    std::map<std::pair<chat::Id128, chat::Id128>, TimeOrderedIndex> messages_by_conversation_;
+    // 冷层：按时间从旧到新
+    std::vector<std::unique_ptr<ColdSegment>> cold_;
+    // 按接收者统计的未读消息数（覆盖热层和冷层）
+    std::unordered_map<chat::Id128, UnreadCounter, chat::Id128Hash> unread_;
+
+    std::condition_variable compact_cv_;
+    bool stopping_;
+    std::thread compactor_;
+};
+
+#endif // MESSAGE_STORE_H
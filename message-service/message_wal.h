@@ -0,0 +1,410 @@
+#ifndef MESSAGE_WAL_H
+#define MESSAGE_WAL_H
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief WAL参数
+ */
+struct WalOptions {
+    std::string directory = "message_wal";             // 段文件所在目录
+    size_t max_segment_bytes = 64 * 1024 * 1024;       // 单个段的大小上限，超过后切换到新段
+    std::chrono::microseconds max_commit_delay{0};     // 组提交前额外等待更多写入的时间，0表示不等待
+};
+
+/**
+ * @brief 分段、仅追加的预写日志
+ * 每条记录格式：[长度(4)][CRC32(4)][类型(1)][数据]，长度和CRC覆盖类型与数据。
+ * 写入方Append后立即返回序号，由后台线程把期间积累的所有记录一次write+fdatasync（组提交），
+ * WaitDurable等到该序号落盘；并发写入越多，每条记录分摊的fdatasync越少。
+ * 段文件名为起始序号，恢复时按序号顺序回放；末尾不完整或校验失败的记录视为崩溃时未写完，截断丢弃
+ */
+class MessageWal {
+public:
+    using Replayer = std::function<void(uint64_t sequence, uint8_t type, const uint8_t* data, size_t size)>;
+
+    explicit MessageWal(const WalOptions& options)
+        : options_(options), fd_(-1), segment_bytes_(0), next_sequence_(1), durable_sequence_(0),
+          stopping_(false), failed_(false) {}
+
+    ~MessageWal() {
+        Close();
+    }
+
+    MessageWal(const MessageWal&) = delete;
+    MessageWal& operator=(const MessageWal&) = delete;
+
+    /**
+     * @brief 回放已有的段并打开日志以供追加，启动时调用一次
+     * @throws std::runtime_error 目录或段文件无法读写
+     */
+    void Open(const Replayer& replay) {
+        if (mkdir(options_.directory.c_str(), 0755) < 0 && errno != EEXIST) {
+            throw std::runtime_error("创建WAL目录失败: " + options_.directory);
+        }
+
+        auto segments = ListSegments();
+        for (size_t i = 0; i < segments.size(); ++i) {
+            bool last = i + 1 == segments.size();
+            ReplaySegment(segments[i], last, replay);
+        }
+
+        segments_ = segments;
+        if (segments.empty()) {
+            OpenSegment(next_sequence_);
+            segments_.push_back(next_sequence_);
+        } else {
+            // 继续写最后一个段
+            std::string path = SegmentPath(segments.back());
+            fd_ = open(path.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+            if (fd_ < 0) {
+                throw std::runtime_error("打开WAL段失败: " + path);
+            }
+            segment_bytes_ = FileSize(fd_);
+        }
+        durable_sequence_ = next_sequence_ - 1;
+
+        flusher_ = std::thread([this]() { FlushLoop(); });
+    }
+
+    /**
+     * @brief 追加一条记录到待提交缓冲区
+     * 调用方若持有自己的锁再调用，记录在日志中的顺序与内存中的修改顺序一致
+     * @return 记录序号，传给WaitDurable等待落盘
+     * @throws std::runtime_error 日志已关闭
+     */
+    uint64_t Append(uint8_t type, const std::vector<uint8_t>& data) {
+        uint32_t length = static_cast<uint32_t>(data.size() + 1);
+        uint32_t crc = Crc32(&type, 1, 0);
+        crc = Crc32(data.data(), data.size(), crc);
+
+        uint64_t sequence;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_) {
+                throw std::runtime_error("WAL已关闭");
+            }
+            AppendField(pending_, length);
+            AppendField(pending_, crc);
+            pending_.push_back(type);
+            pending_.insert(pending_.end(), data.begin(), data.end());
+            sequence = next_sequence_++;
+        }
+        flush_cv_.notify_one();
+        return sequence;
+    }
+
+    /**
+     * @brief 等待序号及之前的记录全部落盘
+     * @throws std::runtime_error 写盘失败
+     */
+    void WaitDurable(uint64_t sequence) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        durable_cv_.wait(lock, [this, sequence]() { return durable_sequence_ >= sequence || failed_; });
+        if (durable_sequence_ < sequence) {
+            throw std::runtime_error("写入WAL失败: " + error_);
+        }
+    }
+
+    /**
+     * @brief 删除所有记录序号都小于sequence的旧段，当前写入的段始终保留
+     * 调用方需保证这些记录的内容已另行持久化（例如已压缩进冷消息段）
+     */
+    void DropSegmentsBefore(uint64_t sequence) {
+        std::vector<uint64_t> dropped;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            while (segments_.size() > 1 && segments_[1] <= sequence) {
+                dropped.push_back(segments_.front());
+                segments_.erase(segments_.begin());
+            }
+        }
+        for (uint64_t first_sequence : dropped) {
+            unlink(SegmentPath(first_sequence).c_str());
+        }
+    }
+
+    /**
+     * @brief 提交剩余记录并关闭日志
+     */
+    void Close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_) {
+                return;
+            }
+            stopping_ = true;
+        }
+        flush_cv_.notify_one();
+        if (flusher_.joinable()) {
+            flusher_.join();
+        }
+        {
+            // 组提交线程已退出，仍在等待的写入方不会再落盘
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!failed_) {
+                failed_ = true;
+                error_ = "WAL已关闭";
+            }
+        }
+        durable_cv_.notify_all();
+        if (fd_ >= 0) {
+            close(fd_);
+            fd_ = -1;
+        }
+    }
+
+private:
+    static constexpr size_t kHeaderSize = 8;
+
+    /**
+     * @brief 组提交线程：每轮取走全部待提交记录，一次写入、一次fdatasync
+     */
+    void FlushLoop() {
+        std::vector<uint8_t> batch;
+        while (true) {
+            uint64_t batch_last;
+            bool stopping;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                flush_cv_.wait(lock, [this]() { return stopping_ || !pending_.empty(); });
+                if (pending_.empty() && stopping_) {
+                    return;
+                }
+                if (options_.max_commit_delay.count() > 0 && !stopping_) {
+                    flush_cv_.wait_for(lock, options_.max_commit_delay);
+                }
+                batch.swap(pending_);
+                batch_last = next_sequence_ - 1;
+                stopping = stopping_;
+            }
+
+            std::string error;
+            if (!failed_) {
+                error = WriteBatch(batch);
+            }
+            batch.clear();
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!error.empty()) {
+                    failed_ = true;
+                    error_ = error;
+                    std::cerr << "写入WAL失败: " << error << std::endl;
+                } else if (!failed_) {
+                    durable_sequence_ = batch_last;
+                }
+            }
+            durable_cv_.notify_all();
+
+            if (stopping && failed_) {
+                return;
+            }
+        }
+    }
+
+    /**
+     * @brief 写入一批记录并落盘，必要时先切换到新段
+     * @return 出错时返回错误描述
+     */
+    std::string WriteBatch(const std::vector<uint8_t>& batch) {
+        if (segment_bytes_ > 0 && segment_bytes_ + batch.size() > options_.max_segment_bytes) {
+            uint64_t first_sequence;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                first_sequence = durable_sequence_ + 1;
+            }
+            close(fd_);
+            fd_ = -1;
+            try {
+                OpenSegment(first_sequence);
+            } catch (const std::exception& e) {
+                return e.what();
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            segments_.push_back(first_sequence);
+        }
+
+        size_t written = 0;
+        while (written < batch.size()) {
+            ssize_t n = write(fd_, batch.data() + written, batch.size() - written);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n < 0) {
+                return std::strerror(errno);
+            }
+            if (n == 0) {
+                // write返回0时不设置errno
+                return "写入了0字节";
+            }
+            written += static_cast<size_t>(n);
+        }
+        segment_bytes_ += written;
+
+        if (fdatasync(fd_) < 0) {
+            return std::strerror(errno);
+        }
+        return std::string();
+    }
+
+    void OpenSegment(uint64_t first_sequence) {
+        std::string path = SegmentPath(first_sequence);
+        fd_ = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd_ < 0) {
+            throw std::runtime_error("创建WAL段失败: " + path);
+        }
+        segment_bytes_ = 0;
+
+        // 新段的目录项也要落盘，否则崩溃后整个段可能不可见
+        int dir_fd = open(options_.directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dir_fd >= 0) {
+            fsync(dir_fd);
+            close(dir_fd);
+        }
+    }
+
+    /**
+     * @brief 回放一个段，最后一个段末尾的残缺记录会被截断
+     */
+    void ReplaySegment(uint64_t first_sequence, bool last, const Replayer& replay) {
+        std::string path = SegmentPath(first_sequence);
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::runtime_error("读取WAL段失败: " + path);
+        }
+        std::vector<uint8_t> content(FileSize(fd));
+        size_t read_bytes = 0;
+        while (read_bytes < content.size()) {
+            ssize_t n = read(fd, content.data() + read_bytes, content.size() - read_bytes);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                break;
+            }
+            read_bytes += static_cast<size_t>(n);
+        }
+        close(fd);
+        content.resize(read_bytes);
+
+        next_sequence_ = std::max(next_sequence_, first_sequence);
+        size_t offset = 0;
+        while (offset + kHeaderSize <= content.size()) {
+            uint32_t length;
+            uint32_t crc;
+            std::memcpy(&length, content.data() + offset, 4);
+            std::memcpy(&crc, content.data() + offset + 4, 4);
+            if (length == 0 || offset + kHeaderSize + length > content.size()) {
+                break;
+            }
+            const uint8_t* body = content.data() + offset + kHeaderSize;
+            if (Crc32(body, length, 0) != crc) {
+                break;
+            }
+            replay(next_sequence_, body[0], body + 1, length - 1);
+            offset += kHeaderSize + length;
+            ++next_sequence_;
+        }
+
+        if (offset < content.size()) {
+            if (!last) {
+                throw std::runtime_error("WAL段损坏: " + path);
+            }
+            std::cerr << "WAL末尾有 " << (content.size() - offset) << " 字节不完整的记录，已截断" << std::endl;
+            if (truncate(path.c_str(), static_cast<off_t>(offset)) < 0) {
+                throw std::runtime_error("截断WAL段失败: " + path);
+            }
+        }
+    }
+
+    std::vector<uint64_t> ListSegments() const {
+        std::vector<uint64_t> segments;
+        DIR* dir = opendir(options_.directory.c_str());
+        if (dir == nullptr) {
+            throw std::runtime_error("打开WAL目录失败: " + options_.directory);
+        }
+        while (dirent* entry = readdir(dir)) {
+            unsigned long long first_sequence;
+            char suffix[8];
+            if (std::sscanf(entry->d_name, "wal-%20llu.%7s", &first_sequence, suffix) == 2 &&
+                std::strcmp(suffix, "log") == 0) {
+                segments.push_back(first_sequence);
+            }
+        }
+        closedir(dir);
+        std::sort(segments.begin(), segments.end());
+        return segments;
+    }
+
+    std::string SegmentPath(uint64_t first_sequence) const {
+        char name[32];
+        std::snprintf(name, sizeof(name), "wal-%020llu.log", static_cast<unsigned long long>(first_sequence));
+        return options_.directory + "/" + name;
+    }
+
+    static size_t FileSize(int fd) {
+        struct stat st;
+        return fstat(fd, &st) == 0 ? static_cast<size_t>(st.st_size) : 0;
+    }
+
+    static void AppendField(std::vector<uint8_t>& buffer, uint32_t value) {
+        const uint8_t* ptr = reinterpret_cast<const uint8_t*>(&value);
+        buffer.insert(buffer.end(), ptr, ptr + sizeof(value));
+    }
+
+    static uint32_t Crc32(const uint8_t* data, size_t size, uint32_t crc) {
+        static const auto table = []() {
+            std::array<uint32_t, 256> t{};
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; ++k) {
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                }
+                t[i] = c;
+            }
+            return t;
+        }();
+        crc = ~crc;
+        for (size_t i = 0; i < size; ++i) {
+            crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+
+    WalOptions options_;
+    int fd_;                     // 当前段，只由组提交线程写入
+    size_t segment_bytes_;
+    std::vector<uint64_t> segments_;      // 现存段的起始序号，最后一个为当前段
+
+    std::mutex mutex_;
+    std::condition_variable flush_cv_;    // 唤醒组提交线程
+    std::condition_variable durable_cv_;  // 通知等待落盘的写入方
+    std::vector<uint8_t> pending_;        // 待提交的记录
+    uint64_t next_sequence_;
+    uint64_t durable_sequence_;
+    bool stopping_;
+    bool failed_;
+    std::string error_;
+    std::thread flusher_;
+};
+
+#endif // MESSAGE_WAL_H
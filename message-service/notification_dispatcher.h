@@ -0,0 +1,200 @@
+#ifndef NOTIFICATION_DISPATCHER_H
+#define NOTIFICATION_DISPATCHER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../common/mpmc_queue.h"
+#include "../common/models.h"
+#include "../common/tcp_client.h"
+#include "../common/telemetry.h"
+
+/**
+ * @brief 新消息通知的投递参数
+ */
+struct NotificationDispatcherOptions {
+    bool enabled = true;                             // 为false时发送消息不产生通知
+    std::string host = "127.0.0.1";                  // notification-service地址
+    int port = 8083;
+    size_t max_queue_size = 8192;                    // 等待投递的通知上限，队列满时直接丢弃新通知
+    size_t max_batch_size = 256;                     // 单次notification.send_batch的最大通知数
+    std::chrono::milliseconds flush_interval{20};    // 不满一批时的最长等待时间
+};
+
+/**
+ * @brief 新消息通知的异步批量投递器
+ * 发送消息的请求线程只把通知放进无锁有界队列，由后台线程攒批后以一次notification.send_batch投递，
+ * 不等待notification-service，也不影响消息发送的结果。notification-service不可用或变慢时只会丢弃通知，不重试
+ */
+class NotificationDispatcher {
+public:
+    explicit NotificationDispatcher(const NotificationDispatcherOptions& options = NotificationDispatcherOptions())
+        : options_(options), queue_(options.max_queue_size), stopping_(false),
+          sent_count_(0), dropped_count_(0), failed_count_(0) {
+        if (options_.max_batch_size == 0) {
+            options_.max_batch_size = 1;
+        }
+        if (options_.enabled) {
+            worker_ = std::thread([this]() { SendLoop(); });
+        }
+    }
+
+    ~NotificationDispatcher() {
+        Stop();
+    }
+
+    NotificationDispatcher(const NotificationDispatcher&) = delete;
+    NotificationDispatcher& operator=(const NotificationDispatcher&) = delete;
+
+    /**
+     * @brief 请求线程上唯一的开销：一次无锁入队；攒满一批时唤醒投递线程
+     * @return 未启用、已停止或队列已满时返回false，通知被丢弃
+     */
+    bool Enqueue(chat::models::NotificationRequest&& notification) {
+        if (!options_.enabled) {
+            return false;
+        }
+        if (stopping_.load(std::memory_order_relaxed) || !queue_.TryPush(std::move(notification))) {
+            dropped_count_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        if (queue_.SizeApprox() >= options_.max_batch_size) {
+            cv_.notify_one();
+        }
+        return true;
+    }
+
+    /**
+     * @brief 停止投递线程，投递队列中剩余的通知
+     */
+    void Stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_.exchange(true)) {
+                return;
+            }
+        }
+        cv_.notify_one();
+        if (worker_.joinable()) {
+            worker_.join();
+            std::cout << "通知投递统计: 已投递 " << sent_count_.load()
+                      << ", 队列满丢弃 " << dropped_count_.load()
+                      << ", 投递失败 " << failed_count_.load() << std::endl;
+        }
+    }
+
+    uint64_t SentCount() const {
+        return sent_count_.load(std::memory_order_relaxed);
+    }
+
+    uint64_t DroppedCount() const {
+        return dropped_count_.load(std::memory_order_relaxed);
+    }
+
+private:
+    void SendLoop() {
+        uint64_t reported_dropped = 0;
+        while (true) {
+            bool stopping;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait_for(lock, options_.flush_interval, [this]() {
+                    return stopping_.load() || queue_.SizeApprox() >= options_.max_batch_size;
+                });
+                stopping = stopping_.load();
+            }
+
+            SendQueued();
+
+            uint64_t dropped = dropped_count_.load(std::memory_order_relaxed);
+            if (dropped != reported_dropped) {
+                std::cerr << "通知队列已满，累计丢弃 " << dropped << " 条通知" << std::endl;
+                reported_dropped = dropped;
+            }
+
+            if (stopping) {
+                break;
+            }
+        }
+    }
+
+    /**
+     * @brief 按批投递队列中已有的通知
+     */
+    void SendQueued() {
+        chat::models::NotificationBatchRequest batch;
+        batch.notifications.reserve(options_.max_batch_size);
+
+        while (true) {
+            chat::models::NotificationRequest notification;
+            while (batch.notifications.size() < options_.max_batch_size && queue_.TryPop(notification)) {
+                batch.notifications.push_back(std::move(notification));
+            }
+            if (batch.notifications.empty()) {
+                return;
+            }
+
+            SendBatch(batch);
+
+            bool full_batch = batch.notifications.size() == options_.max_batch_size;
+            batch.notifications.clear();
+            if (!full_batch) {
+                return;
+            }
+        }
+    }
+
+    void SendBatch(const chat::models::NotificationBatchRequest& batch) {
+        auto scope = CreateSpan("message_service.dispatch_notifications");
+        auto span = GetCurrentSpan();
+        if (span->IsRecording()) {
+            span->SetAttribute("batch_size", static_cast<int>(batch.notifications.size()));
+            span->SetAttribute("protocol", "tcp");
+        }
+
+        try {
+            auto response = tcp_client::SendRequest<chat::models::NotificationBatchRequest,
+                                                    chat::models::NotificationBatchResponse>(
+                options_.host, options_.port, "notification.send_batch", batch);
+            if (!response.success) {
+                throw std::runtime_error(response.message);
+            }
+            sent_count_.fetch_add(response.delivered_count, std::memory_order_relaxed);
+            failed_count_.fetch_add(response.failed_count, std::memory_order_relaxed);
+            span->SetStatus(trace::StatusCode::kOk);
+            unavailable_ = false;
+
+        } catch (const std::exception& e) {
+            failed_count_.fetch_add(batch.notifications.size(), std::memory_order_relaxed);
+            span->SetStatus(trace::StatusCode::kError, e.what());
+            // 服务持续不可用时只在状态变化时打印一次
+            if (!unavailable_) {
+                std::cerr << "投递通知失败: " << e.what() << std::endl;
+                unavailable_ = true;
+            }
+        }
+    }
+
+    NotificationDispatcherOptions options_;
+    BoundedMpmcQueue<chat::models::NotificationRequest> queue_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;  // 唤醒投递线程
+    std::atomic<bool> stopping_;
+    bool unavailable_ = false;    // 只由投递线程访问
+    std::thread worker_;
+
+    std::atomic<uint64_t> sent_count_;
+    std::atomic<uint64_t> dropped_count_;
+    std::atomic<uint64_t> failed_count_;
+};
+
+#endif // NOTIFICATION_DISPATCHER_H
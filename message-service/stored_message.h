@@ -0,0 +1,83 @@
+#ifndef STORED_MESSAGE_H
+#define STORED_MESSAGE_H
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include "../common/id128.h"
+#include "../common/models.h"
+
+/**
+ * @brief 服务内部保存的消息记录
+ * 消息和用户ID以16字节的值保存，只在返回给调用方或写入WAL时格式化为模型
+ */
+struct StoredMessage {
+    chat::Id128 message_id;
+    chat::Id128 sender_id;
+    chat::Id128 receiver_id;
+    int64_t timestamp = 0;
+    bool is_read = false;
+    std::string content;
+    std::string message_type;
+
+    chat::models::Message ToMessage() const {
+        chat::models::Message message;
+        message.message_id = message_id.ToString();
+        message.sender_id = sender_id.ToString();
+        message.receiver_id = receiver_id.ToString();
+        message.content = content;
+        message.message_type = message_type;
+        message.is_read = is_read;
+        message.timestamp = timestamp;
+        return message;
+    }
+
+    /**
+     * @brief 从模型转换（回放WAL时使用）
+     * @throws std::runtime_error ID格式不正确
+     */
+    static StoredMessage FromMessage(const chat::models::Message& message) {
+        StoredMessage stored;
+        if (!chat::Id128::Parse(message.message_id, stored.message_id) ||
+            !chat::Id128::Parse(message.sender_id, stored.sender_id) ||
+            !chat::Id128::Parse(message.receiver_id, stored.receiver_id)) {
+            throw std::runtime_error("消息ID格式错误: " + message.message_id);
+        }
+        stored.content = message.content;
+        stored.message_type = message.message_type;
+        stored.is_read = message.is_read;
+        stored.timestamp = message.timestamp;
+        return stored;
+    }
+};
+
+/**
+ * @brief 消息的排列顺序：先按时间戳，同一毫秒内按消息ID
+ */
+inline bool MessageOrderLess(int64_t a_timestamp, const chat::Id128& a_id,
+                             int64_t b_timestamp, const chat::Id128& b_id) {
+    return a_timestamp != b_timestamp ? a_timestamp < b_timestamp : a_id < b_id;
+}
+
+/**
+ * @brief 消息分页游标，指向上一页最后一条消息
+ * 同一毫秒内的多条消息以消息ID区分先后，翻页时不会跳过与上一页最后一条处于同一毫秒的消息
+ */
+struct MessageCursor {
+    int64_t timestamp = 0;   // <=0表示从最新一条开始
+    chat::Id128 message_id;  // 空ID表示只按时间戳比较，返回早于该时间戳的全部消息
+
+    bool IsSet() const {
+        return timestamp > 0;
+    }
+
+    /**
+     * @brief 该消息是否排在游标之前
+     */
+    bool IsBefore(int64_t other_timestamp, const chat::Id128& other_message_id) const {
+        return MessageOrderLess(other_timestamp, other_message_id, timestamp, message_id);
+    }
+};
+
+#endif // STORED_MESSAGE_H
@@ -3,11 +3,12 @@
 
 #include "../common/tcp_service_base.h"
 #include "../common/models.h"
+#include "../common/user_cache.h"
+#include "../common/id128.h"
+#include "message_store.h"
+#include "notification_dispatcher.h"
 #include <string>
-#include <map>
 #include <vector>
-#include <mutex>
-#include <random>
 #include <chrono>
 
 /**
@@ -20,19 +21,33 @@ public:
      * @brief 构造函数
      */
     TcpMessageService(const std::string& host, int port,
-                      const std::string& user_service_host, int user_service_port)
+                      const std::string& user_service_host, int user_service_port,
+                      const MessageStoreOptions& store_options = MessageStoreOptions(),
+                      const NotificationDispatcherOptions& notification_options = NotificationDispatcherOptions())
         : TcpServiceBase("message-service", "1.0.0", host, port),
-          user_service_host_(user_service_host),
-          user_service_port_(user_service_port) {
-        // 初始化随机数生成器
-        std::random_device rd;
-        random_engine_ = std::mt19937(rd());
+          store_(store_options),
+          users_(user_service_host, user_service_port),
+          notifications_(notification_options) {
+        // 映射冷消息段并回放WAL恢复热层
+        store_.Open();
     }
 
     /**
      * @brief 析构函数
      */
-    ~TcpMessageService() = default;
+    ~TcpMessageService() {
+        // 先停止处理请求，再随成员析构关闭消息存储
+        Stop();
+    }
+
+    /**
+     * @brief 停止服务：先投递完排队的通知（此时遥测仍可用），再停止处理请求
+     * 停止期间仍在处理的发送请求不再产生通知
+     */
+    void Stop() override {
+        notifications_.Stop();
+        TcpServiceBase::Stop();
+    }
 
 protected:
     /**
@@ -62,6 +77,14 @@ protected:
                 return MarkMessageRead(request);
             }
         );
+
+        // 注册获取未读消息数处理器
+        RegisterHandler<chat::models::GetUnreadCountsRequest, chat::models::GetUnreadCountsResponse>(
+            "message.unread_counts",
+            [this](const chat::models::GetUnreadCountsRequest& request) {
+                return GetUnreadCounts(request);
+            }
+        );
     }
 
 private:
@@ -72,68 +95,65 @@ private:
         auto scope = CreateSpan("message_service.send_message");
         auto span = GetCurrentSpan();
         
-        span->SetAttribute("sender_id", request.sender_id);
-        span->SetAttribute("receiver_id", request.receiver_id);
-        span->SetAttribute("message_length", static_cast<int>(request.content.length()));
-        span->SetAttribute("protocol", "tcp");
+        if (span->IsRecording()) {
+            span->SetAttribute("sender_id", request.sender_id);
+            span->SetAttribute("receiver_id", request.receiver_id);
+            span->SetAttribute("message_length", static_cast<int>(request.content.length()));
+            span->SetAttribute("protocol", "tcp");
+        }
         
         chat::models::SendMessageResponse response;
         
         try {
-            // 验证发送者
-            span->AddEvent("validating_sender");
-            if (!ValidateUser(request.sender_id)) {
+            // 一次请求同时验证发送者和接收者，格式不正确的ID视为不存在
+            span->AddEvent("validating_users");
+            chat::Id128 sender_id;
+            chat::Id128 receiver_id;
+            bool sender_parsed = chat::Id128::Parse(request.sender_id, sender_id);
+            bool receiver_parsed = chat::Id128::Parse(request.receiver_id, receiver_id);
+            std::vector<bool> valid{false, false};
+            if (sender_parsed && receiver_parsed) {
+                valid = users_.ValidateAll({sender_id, receiver_id});
+            }
+            if (!valid[0]) {
                 response.success = false;
                 response.message = "发送者不存在";
                 span->SetStatus(trace::StatusCode::kError, "发送者不存在");
                 return response;
             }
             
-            // 验证接收者  
-            span->AddEvent("validating_receiver");
-            if (!ValidateUser(request.receiver_id)) {
+            if (!valid[1]) {
                 response.success = false;
                 response.message = "接收者不存在";
                 span->SetStatus(trace::StatusCode::kError, "接收者不存在");
                 return response;
             }
             
-            std::unique_lock<std::mutex> lock(mutex_);
-            
-            // 生成消息ID
-            std::string message_id = GenerateUUID();
-            
-            // 创建消息
+            // 创建消息（按时间排序的128位ID，只在响应中格式化为字符串）
             span->AddEvent("creating_message");
-            chat::models::Message message;
-            message.message_id = message_id;
-            message.sender_id = request.sender_id;
-            message.receiver_id = request.receiver_id;
+            StoredMessage message;
+            message.message_id = chat::Id128::Generate();
+            message.sender_id = sender_id;
+            message.receiver_id = receiver_id;
             message.content = request.content;
             message.timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
                 std::chrono::system_clock::now().time_since_epoch()).count();
             message.is_read = false;
             
-            // 存储消息
-            messages_by_id_[message_id] = message;
-            
-            // 更新索引
-            messages_by_user_[request.sender_id].push_back(message_id);
-            messages_by_user_[request.receiver_id].push_back(message_id);
-            
-            // 会话索引（用户对）
-            auto conversation_key = std::make_pair(
-                std::min(request.sender_id, request.receiver_id),
-                std::max(request.sender_id, request.receiver_id)
-            );
-            messages_by_conversation_[conversation_key].push_back(message_id);
+            // 写入WAL并等待组提交落盘后再确认发送成功
+            store_.Add(message);
             
             response.success = true;
             response.message = "消息发送成功";
-            response.message_id = message_id;
+            response.message_id = message.message_id.ToString();
             response.timestamp = message.timestamp;
             
-            span->SetAttribute("message_id", message_id);
+            // 给接收者的新消息通知交给后台批量投递，不等待notification-service
+            if (!notifications_.Enqueue(MakeMessageNotification(request, response.message_id))) {
+                span->AddEvent("notification_dropped");
+            }
+            
+            span->SetAttribute("message_id", response.message_id);
             span->SetStatus(trace::StatusCode::kOk);
             span->AddEvent("message_sent");
             
@@ -147,6 +167,31 @@ private:
         return response;
     }
 
+    /**
+     * @brief 构造给接收者的新消息通知，内容为消息的前若干字节（按UTF-8字符边界截断）
+     */
+    static chat::models::NotificationRequest MakeMessageNotification(const chat::models::SendMessageRequest& request,
+                                                                     const std::string& message_id) {
+        chat::models::NotificationRequest notification;
+        notification.user_id = request.receiver_id;
+        notification.title = "新消息";
+        notification.type = "message";
+        
+        size_t length = request.content.size();
+        if (length > kNotificationPreviewBytes) {
+            length = kNotificationPreviewBytes;
+            while (length > 0 && (static_cast<unsigned char>(request.content[length]) & 0xC0) == 0x80) {
+                --length;
+            }
+        }
+        notification.content = request.content.substr(0, length);
+        notification.metadata = {
+            {"message_id", message_id},
+            {"sender_id", request.sender_id}
+        };
+        return notification;
+    }
+
     /**
      * @brief 获取消息列表
      */
@@ -154,10 +199,12 @@ private:
         auto scope = CreateSpan("message_service.get_messages");
         auto span = GetCurrentSpan();
         
-        span->SetAttribute("user_id", request.user_id);
-        span->SetAttribute("protocol", "tcp");
-        if (!request.other_user_id.empty()) {
-            span->SetAttribute("other_user_id", request.other_user_id);
+        if (span->IsRecording()) {
+            span->SetAttribute("user_id", request.user_id);
+            span->SetAttribute("protocol", "tcp");
+            if (!request.other_user_id.empty()) {
+                span->SetAttribute("other_user_id", request.other_user_id);
+            }
         }
         
         chat::models::GetMessagesResponse response;
@@ -165,55 +212,40 @@ private:
         try {
             // 验证用户
             span->AddEvent("validating_user");
-            if (!ValidateUser(request.user_id)) {
+            chat::Id128 user_id;
+            if (!users_.Validate(request.user_id, user_id)) {
                 response.success = false;
                 response.message = "用户不存在";
                 span->SetStatus(trace::StatusCode::kError, "用户不存在");
                 return response;
             }
             
-            std::unique_lock<std::mutex> lock(mutex_);
-            
-            std::vector<std::string> message_ids;
-            
+            chat::Id128 other_user_id;
+            bool other_user_valid = true;
             if (!request.other_user_id.empty()) {
-                // 获取与特定用户的会话消息
+                // 获取与特定用户的会话消息，格式不正确的对方ID不会有任何会话
                 span->AddEvent("fetching_conversation_messages");
-                auto conversation_key = std::make_pair(
-                    std::min(request.user_id, request.other_user_id),
-                    std::max(request.user_id, request.other_user_id)
-                );
-                
-                auto conv_it = messages_by_conversation_.find(conversation_key);
-                if (conv_it != messages_by_conversation_.end()) {
-                    message_ids = conv_it->second;
-                }
+                other_user_valid = chat::Id128::Parse(request.other_user_id, other_user_id) && !other_user_id.IsNil();
             } else {
                 // 获取用户所有相关消息
                 span->AddEvent("fetching_all_messages");
-                auto user_it = messages_by_user_.find(request.user_id);
-                if (user_it != messages_by_user_.end()) {
-                    message_ids = user_it->second;
-                }
             }
             
-            // 转换为消息对象
-            for (const auto& msg_id : message_ids) {
-                auto msg_it = messages_by_id_.find(msg_id);
-                if (msg_it != messages_by_id_.end()) {
-                    response.messages.push_back(msg_it->second);
-                }
+            MessageCursor cursor;
+            cursor.timestamp = request.before_timestamp;
+            if (!request.before_message_id.empty() &&
+                !chat::Id128::Parse(request.before_message_id, cursor.message_id)) {
+                response.success = false;
+                response.message = "分页游标格式不正确";
+                span->SetStatus(trace::StatusCode::kError, "分页游标格式不正确");
+                return response;
             }
             
-            // 按时间排序（最新的在前）
-            std::sort(response.messages.begin(), response.messages.end(),
-                     [](const chat::models::Message& a, const chat::models::Message& b) {
-                         return a.timestamp > b.timestamp;
-                     });
-            
-            // 分页处理
-            if (request.limit > 0 && response.messages.size() > request.limit) {
-                response.messages.resize(request.limit);
+            // 从游标向前取最新的limit条（最新的在前），先查热层，不足时继续读冷消息段
+            if (other_user_valid) {
+                auto page = store_.Get(user_id, other_user_id, cursor, request.limit);
+                response.messages = std::move(page.messages);
+                response.has_more = page.has_more;
             }
             
             response.success = true;
@@ -240,36 +272,37 @@ private:
         auto scope = CreateSpan("message_service.mark_read");
         auto span = GetCurrentSpan();
         
-        span->SetAttribute("user_id", request.user_id);
-        span->SetAttribute("message_id", request.message_id);
-        span->SetAttribute("protocol", "tcp");
+        if (span->IsRecording()) {
+            span->SetAttribute("user_id", request.user_id);
+            span->SetAttribute("message_id", request.message_id);
+            span->SetAttribute("protocol", "tcp");
+        }
         
         chat::models::MarkMessageReadResponse response;
         
         try {
-            std::unique_lock<std::mutex> lock(mutex_);
-            
-            auto msg_it = messages_by_id_.find(request.message_id);
-            if (msg_it == messages_by_id_.end()) {
+            // 检查消息存在和权限（只有接收者可以标记已读），落盘后返回
+            chat::Id128 user_id;
+            chat::Id128 message_id;
+            auto result = TieredMessageStore::MarkReadResult::kNotFound;
+            if (chat::Id128::Parse(request.message_id, message_id)) {
+                result = chat::Id128::Parse(request.user_id, user_id) ? store_.MarkRead(user_id, message_id)
+                                                                       : TieredMessageStore::MarkReadResult::kForbidden;
+            }
+            if (result == TieredMessageStore::MarkReadResult::kNotFound) {
                 response.success = false;
                 response.message = "消息不存在";
                 span->SetStatus(trace::StatusCode::kError, "消息不存在");
                 return response;
             }
             
-            chat::models::Message& message = msg_it->second;
-            
-            // 检查权限（只有接收者可以标记已读）
-            if (message.receiver_id != request.user_id) {
+            if (result == TieredMessageStore::MarkReadResult::kForbidden) {
                 response.success = false;
                 response.message = "无权限标记此消息";
                 span->SetStatus(trace::StatusCode::kError, "权限不足");
                 return response;
             }
             
-            // 标记已读
-            message.is_read = true;
-            
             response.success = true;
             response.message = "消息已标记为已读";
             
@@ -287,59 +320,66 @@ private:
     }
 
     /**
-     * @brief 验证用户是否存在（通过TCP调用user-service）
+     * @brief 获取未读消息数
+     * 计数由发送和标记已读增量维护，这里只复制计数器，与历史消息数量无关
      */
-    bool ValidateUser(const std::string& user_id) {
+    chat::models::GetUnreadCountsResponse GetUnreadCounts(const chat::models::GetUnreadCountsRequest& request) {
+        auto scope = CreateSpan("message_service.unread_counts");
+        auto span = GetCurrentSpan();
+        
+        if (span->IsRecording()) {
+            span->SetAttribute("user_id", request.user_id);
+            span->SetAttribute("protocol", "tcp");
+        }
+        
+        chat::models::GetUnreadCountsResponse response;
+        
         try {
-            // 构造获取用户请求
-            chat::models::GetUserRequest request;
-            request.user_id = user_id;
+            // 验证用户
+            span->AddEvent("validating_user");
+            chat::Id128 user_id;
+            if (!users_.Validate(request.user_id, user_id)) {
+                response.success = false;
+                response.message = "用户不存在";
+                span->SetStatus(trace::StatusCode::kError, "用户不存在");
+                return response;
+            }
             
-            // 通过TCP调用user-service
-            auto response = SendTcpRequest<chat::models::GetUserRequest, chat::models::UserInfo>(
-                user_service_host_, user_service_port_, "user.get", request
-            );
+            auto summary = store_.UnreadCounts(user_id);
+            response.total_unread = static_cast<int64_t>(summary.total);
+            response.conversations.reserve(summary.by_sender.size());
+            for (const auto& entry : summary.by_sender) {
+                chat::models::ConversationUnread conversation;
+                conversation.other_user_id = entry.first.ToString();
+                conversation.unread_count = static_cast<int64_t>(entry.second);
+                response.conversations.push_back(std::move(conversation));
+            }
             
-            return response.success;
+            response.success = true;
             
-        } catch (const std::exception& e) {
-            std::cerr << "验证用户失败: " << e.what() << std::endl;
-            return false;
-        }
-    }
-
-    /**
-     * @brief 生成UUID
-     */
-    std::string GenerateUUID() {
-        std::uniform_int_distribution<> dis(0, 15);
-        std::stringstream ss;
-        ss << std::hex;
-        
-        for (int i = 0; i < 32; ++i) {
-            if (i == 8 || i == 12 || i == 16 || i == 20) {
-                ss << "-";
+            if (span->IsRecording()) {
+                span->SetAttribute("total_unread", response.total_unread);
             }
-            ss << dis(random_engine_);
+            span->SetStatus(trace::StatusCode::kOk);
+            
+        } catch (const std::exception& e) {
+            response.success = false;
+            response.message = std::string("获取未读消息数失败: ") + e.what();
+            
+            span->SetStatus(trace::StatusCode::kError, e.what());
         }
         
-        return ss.str();
+        return response;
     }
 
-    // 消息存储
-    std::map<std::string, chat::models::Message> messages_by_id_;
-    // 按用户ID存储收发的消息ID
-    std::map<std::string, std::vector<std::string>> messages_by_user_;
-    // 按会话存储消息ID（用户ID对）
-    std::map<std::pair<std::string, std::string>, std::vector<std::string>> messages_by_conversation_;
-    // 互斥锁
-    std::mutex mutex_;
-    // 随机数生成器
-    std::mt19937 random_engine_;
+    // 消息存储：热层 + mmap冷消息段，修改先写WAL
+    TieredMessageStore store_;
+    // 经缓存向user-service校验用户
+    UserServiceValidator users_;
+    // 新消息通知的异步批量投递
+    NotificationDispatcher notifications_;
     
-    // user-service连接信息
-    std::string user_service_host_;
-    int user_service_port_;
+    static constexpr size_t kNotificationPreviewBytes = 120;  // 通知中消息预览的最大字节数
 };
 
 #endif // TCP_MESSAGE_SERVICE_H
\ No newline at end of file
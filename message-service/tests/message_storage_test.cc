@@ -0,0 +1,326 @@
+// 消息存储测试：WAL崩溃恢复、冷消息段格式校验、已读标记跨压缩的持久化
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../cold_segment.h"
+#include "../message_store.h"
+#include "../message_wal.h"
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(condition)                                                              \
+    do {                                                                              \
+        if (!(condition)) {                                                           \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": 检查失败: " #condition << std::endl; \
+            ++failures;                                                               \
+        }                                                                             \
+    } while (0)
+
+/**
+ * @brief 测试用的临时目录，析构时连同其中的文件一起删除
+ */
+class TempDirectory {
+public:
+    TempDirectory() {
+        char path[] = "/tmp/message-storage-test-XXXXXX";
+        if (mkdtemp(path) == nullptr) {
+            throw std::runtime_error("创建临时目录失败");
+        }
+        path_ = path;
+    }
+
+    ~TempDirectory() {
+        if (DIR* dir = opendir(path_.c_str())) {
+            while (dirent* entry = readdir(dir)) {
+                std::string name = entry->d_name;
+                if (name != "." && name != "..") {
+                    unlink((path_ + "/" + name).c_str());
+                }
+            }
+            closedir(dir);
+        }
+        rmdir(path_.c_str());
+    }
+
+    const std::string& Path() const {
+        return path_;
+    }
+
+private:
+    std::string path_;
+};
+
+bool FileExists(const std::string& path) {
+    return access(path.c_str(), F_OK) == 0;
+}
+
+size_t FileSize(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 ? static_cast<size_t>(st.st_size) : 0;
+}
+
+void AppendBytes(const std::string& path, const std::vector<uint8_t>& bytes) {
+    int fd = open(path.c_str(), O_WRONLY | O_APPEND);
+    if (fd < 0 || write(fd, bytes.data(), bytes.size()) != static_cast<ssize_t>(bytes.size())) {
+        throw std::runtime_error("写入测试文件失败: " + path);
+    }
+    close(fd);
+}
+
+void OverwriteBytes(const std::string& path, off_t offset, const void* data, size_t size) {
+    int fd = open(path.c_str(), O_WRONLY);
+    if (fd < 0 || pwrite(fd, data, size, offset) != static_cast<ssize_t>(size)) {
+        throw std::runtime_error("写入测试文件失败: " + path);
+    }
+    close(fd);
+}
+
+/**
+ * @brief 轮询等待条件成立（压缩在后台线程进行）
+ */
+bool WaitFor(const std::function<bool()>& condition) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (condition()) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return condition();
+}
+
+std::string WalSegmentPath(const std::string& directory, uint64_t first_sequence) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "wal-%020llu.log", static_cast<unsigned long long>(first_sequence));
+    return directory + "/" + name;
+}
+
+StoredMessage MakeMessage(const chat::Id128& sender, const chat::Id128& receiver, int64_t timestamp) {
+    StoredMessage message;
+    message.message_id = chat::Id128::Generate();
+    message.sender_id = sender;
+    message.receiver_id = receiver;
+    message.timestamp = timestamp;
+    message.content = "content " + std::to_string(timestamp);
+    message.message_type = "text";
+    return message;
+}
+
+/**
+ * @brief 最后一个段末尾的记录只写了一半：回放到最后一条完整记录为止，残缺部分被截断，之后可以继续追加
+ */
+void TestWalReplayTruncatedTail() {
+    TempDirectory directory;
+    WalOptions options;
+    options.directory = directory.Path();
+    std::string segment = WalSegmentPath(directory.Path(), 1);
+
+    {
+        MessageWal wal(options);
+        wal.Open([](uint64_t, uint8_t, const uint8_t*, size_t) {});
+        uint64_t last = 0;
+        for (uint8_t i = 0; i < 3; ++i) {
+            last = wal.Append(1, std::vector<uint8_t>(10, i));
+        }
+        wal.WaitDurable(last);
+    }
+    size_t complete_size = FileSize(segment);
+
+    // 记录头声明100字节，实际只写入了10字节
+    std::vector<uint8_t> torn = {101, 0, 0, 0, 0, 0, 0, 0};
+    torn.resize(torn.size() + 10, 0xab);
+    AppendBytes(segment, torn);
+
+    std::vector<std::pair<uint64_t, std::vector<uint8_t>>> replayed;
+    auto collect = [&replayed](uint64_t sequence, uint8_t type, const uint8_t* data, size_t size) {
+        CHECK(type == 1);
+        replayed.emplace_back(sequence, std::vector<uint8_t>(data, data + size));
+    };
+    {
+        MessageWal wal(options);
+        wal.Open(collect);
+        CHECK(replayed.size() == 3);
+        for (size_t i = 0; i < replayed.size(); ++i) {
+            CHECK(replayed[i].first == i + 1);
+            CHECK(replayed[i].second == std::vector<uint8_t>(10, static_cast<uint8_t>(i)));
+        }
+        CHECK(FileSize(segment) == complete_size);
+
+        uint64_t sequence = wal.Append(1, std::vector<uint8_t>(10, 3));
+        CHECK(sequence == 4);
+        wal.WaitDurable(sequence);
+    }
+
+    replayed.clear();
+    MessageWal wal(options);
+    wal.Open(collect);
+    CHECK(replayed.size() == 4);
+    CHECK(!replayed.empty() && replayed.back().second == std::vector<uint8_t>(10, 3));
+}
+
+/**
+ * @brief 段头、字典编码或倒排表损坏的冷消息段在打开时被拒绝，而不是在查询时越界访问
+ */
+void TestColdSegmentRejectsCorruption() {
+    TempDirectory directory;
+    std::string path = directory.Path() + "/cold-00000000000000000001.seg";
+    chat::Id128 alice = chat::Id128::Generate();
+    chat::Id128 bob = chat::Id128::Generate();
+    std::vector<StoredMessage> messages;
+    for (int i = 0; i < 5; ++i) {
+        messages.push_back(MakeMessage(i % 2 ? alice : bob, i % 2 ? bob : alice, 1000 + i));
+    }
+    ColdSegment::Write(path, messages);
+    CHECK(ColdSegment::Open(path)->RowCount() == 5);
+
+    auto rejected = [&path]() {
+        try {
+            ColdSegment::Open(path);
+            return false;
+        } catch (const std::runtime_error&) {
+            return true;
+        }
+    };
+
+    // 段头：magic(8) + 4个uint32计数(16) + 各区起始偏移(uint64)，区的顺序见ColdSegment::Section
+    constexpr off_t kSectionsOffset = 24;
+    constexpr int kSenders = 1;
+    constexpr int kUserPostings = 12;
+    auto section_offset = [&path](int section) {
+        uint64_t offset = 0;
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd >= 0) {
+            ssize_t n = pread(fd, &offset, sizeof(offset), kSectionsOffset + section * 8);
+            (void)n;
+            close(fd);
+        }
+        return static_cast<off_t>(offset);
+    };
+
+    const uint32_t out_of_range = 0x7fffffff;
+    struct Corruption {
+        const char* name;
+        off_t offset;
+        std::vector<uint8_t> bytes;
+    };
+    std::vector<Corruption> corruptions = {
+        {"magic", 0, {'X'}},
+        {"sender code", section_offset(kSenders), {}},
+        {"user posting row", section_offset(kUserPostings), {}},
+    };
+    for (auto& corruption : corruptions) {
+        if (corruption.bytes.empty()) {
+            corruption.bytes.resize(sizeof(out_of_range));
+            std::memcpy(corruption.bytes.data(), &out_of_range, sizeof(out_of_range));
+        }
+        std::vector<uint8_t> original(corruption.bytes.size());
+        int fd = open(path.c_str(), O_RDONLY);
+        ssize_t n = pread(fd, original.data(), original.size(), corruption.offset);
+        (void)n;
+        close(fd);
+
+        OverwriteBytes(path, corruption.offset, corruption.bytes.data(), corruption.bytes.size());
+        if (!rejected()) {
+            std::cerr << "未检测到损坏: " << corruption.name << std::endl;
+            ++failures;
+        }
+        OverwriteBytes(path, corruption.offset, original.data(), original.size());
+    }
+    CHECK(!rejected());
+
+    // 文件被截短
+    CHECK(truncate(path.c_str(), static_cast<off_t>(FileSize(path) - 8)) == 0);
+    CHECK(rejected());
+}
+
+/**
+ * @brief 压缩前后标记的已读状态都随冷消息段或WAL持久化，重启后已读标记与未读数保持不变
+ */
+void TestMarkReadAcrossCompaction() {
+    TempDirectory directory;
+    MessageStoreOptions options;
+    options.wal.directory = directory.Path();
+    options.wal.max_segment_bytes = 1;   // 每次组提交一个段，压缩后旧段可被删除
+    options.hot_message_limit = 2;
+    options.segment_rows = 2;
+
+    chat::Id128 alice = chat::Id128::Generate();
+    chat::Id128 bob = chat::Id128::Generate();
+    std::vector<StoredMessage> sent;
+
+    auto verify = [&](const TieredMessageStore& store) {
+        auto page = store.Get(bob, alice, MessageCursor(), 0);
+        CHECK(page.messages.size() == sent.size());
+        for (size_t i = 0; i < page.messages.size() && i < sent.size(); ++i) {
+            // 最新的在前
+            const auto& message = page.messages[i];
+            const auto& expected = sent[sent.size() - 1 - i];
+            CHECK(message.message_id == expected.message_id.ToString());
+            CHECK(message.is_read == (i == sent.size() - 1 || i == sent.size() - 3));
+        }
+        CHECK(store.UnreadCounts(bob).total == sent.size() - 2);
+    };
+
+    {
+        TieredMessageStore store(options);
+        store.Open();
+        // 序号1-4：前两条被压缩进第一个冷消息段
+        for (int i = 0; i < 4; ++i) {
+            sent.push_back(MakeMessage(alice, bob, 1000 + i));
+            store.Add(sent.back());
+        }
+        CHECK(WaitFor([&]() { return !FileExists(WalSegmentPath(directory.Path(), 1)); }));
+
+        // 序号5标记冷消息段中的消息，序号6标记仍在热层的消息
+        CHECK(store.MarkRead(bob, sent[0].message_id) == TieredMessageStore::MarkReadResult::kMarked);
+        CHECK(store.MarkRead(bob, sent[2].message_id) == TieredMessageStore::MarkReadResult::kMarked);
+        CHECK(store.MarkRead(alice, sent[1].message_id) == TieredMessageStore::MarkReadResult::kForbidden);
+
+        // 序号7-8：已标记的热层消息被压缩进第二个冷消息段，两条已读标记所在的WAL段随之删除
+        for (int i = 4; i < 6; ++i) {
+            sent.push_back(MakeMessage(alice, bob, 1000 + i));
+            store.Add(sent.back());
+        }
+        CHECK(WaitFor([&]() { return !FileExists(WalSegmentPath(directory.Path(), 6)); }));
+        verify(store);
+    }
+
+    TieredMessageStore reopened(options);
+    reopened.Open();
+    verify(reopened);
+}
+
+} // namespace
+
+int main() {
+    const std::pair<const char*, void (*)()> tests[] = {
+        {"WalReplayTruncatedTail", TestWalReplayTruncatedTail},
+        {"ColdSegmentRejectsCorruption", TestColdSegmentRejectsCorruption},
+        {"MarkReadAcrossCompaction", TestMarkReadAcrossCompaction},
+    };
+    for (const auto& test : tests) {
+        int before = failures;
+        try {
+            test.second();
+        } catch (const std::exception& e) {
+            std::cerr << test.first << ": 异常: " << e.what() << std::endl;
+            ++failures;
+        }
+        std::cout << (failures == before ? "[通过] " : "[失败] ") << test.first << std::endl;
+    }
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -28,6 +28,7 @@ int main(int argc, char* argv[]) {
         int port = 8083;
         std::string user_service_host = "127.0.0.1";
         int user_service_port = 8081;
+        size_t retention_per_user = 1000;
         
         if (argc >= 2) {
             host = argv[1];
@@ -41,14 +42,19 @@ int main(int argc, char* argv[]) {
         if (argc >= 5) {
             user_service_port = std::stoi(argv[4]);
         }
+        if (argc >= 6) {
+            retention_per_user = std::stoul(argv[5]);
+        }
         
         std::cout << "启动参数:" << std::endl;
         std::cout << "- 主机: " << host << std::endl;
         std::cout << "- 端口: " << port << std::endl;
         std::cout << "- 用户服务: " << user_service_host << ":" << user_service_port << std::endl;
+        std::cout << "- 每个用户保留的通知数: " << retention_per_user << std::endl;
         
         // 创建服务实例
-        g_service = std::make_unique<TcpNotificationService>(host, port, user_service_host, user_service_port);
+        g_service = std::make_unique<TcpNotificationService>(host, port, user_service_host, user_service_port,
+                                                             retention_per_user);
         
         // 启动服务
         g_service->Start();
@@ -56,7 +62,10 @@ int main(int argc, char* argv[]) {
         std::cout << "TCP通知服务启动成功！" << std::endl;
         std::cout << "支持的消息类型:" << std::endl;
         std::cout << "- notification.send: 发送通知" << std::endl;
+        std::cout << "- notification.send_bulk: 批量发送通知" << std::endl;
+        std::cout << "- notification.send_batch: 批量提交多条通知" << std::endl;
         std::cout << "- notification.get: 获取通知列表" << std::endl;
+        std::cout << "- notification.subscribe: 订阅新通知（长轮询）" << std::endl;
         std::cout << "按 Ctrl+C 停止服务" << std::endl;
         
         // 等待服务结束
@@ -0,0 +1,163 @@
+#ifndef NOTIFICATION_METADATA_H
+#define NOTIFICATION_METADATA_H
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/**
+ * @brief 通知元数据键的字典
+ * 元数据的键集合很小且高度重复（message_id、sender_id等），每个键只保存一份，通知中只记录编号。
+ * 只增不减；键数达到上限后不再收录新键，新键由PackedMetadata内联保存，防止客户端任意键撑大字典。
+ * 不加锁，调用方需持有保护通知存储的锁
+ */
+class MetadataKeyDictionary {
+public:
+    static constexpr uint32_t kNotFound = UINT32_MAX;
+
+    explicit MetadataKeyDictionary(size_t max_keys = 4096) : max_keys_(max_keys) {}
+
+    MetadataKeyDictionary(const MetadataKeyDictionary&) = delete;
+    MetadataKeyDictionary& operator=(const MetadataKeyDictionary&) = delete;
+
+    /**
+     * @brief 取键的编号，未收录时收录
+     * @return 字典已满且键未收录时返回kNotFound
+     */
+    uint32_t Intern(std::string_view key) {
+        auto it = ids_.find(key);
+        if (it != ids_.end()) {
+            return it->second;
+        }
+        if (keys_.size() >= max_keys_) {
+            return kNotFound;
+        }
+        uint32_t id = static_cast<uint32_t>(keys_.size());
+        keys_.emplace_back(key);
+        ids_.emplace(keys_.back(), id);  // deque追加不移动已有元素，string_view保持有效
+        return id;
+    }
+
+    const std::string& Key(uint32_t id) const {
+        return keys_[id];
+    }
+
+    size_t Size() const {
+        return keys_.size();
+    }
+
+private:
+    size_t max_keys_;
+    std::deque<std::string> keys_;
+    std::unordered_map<std::string_view, uint32_t> ids_;
+};
+
+/**
+ * @brief 单条通知的紧凑元数据
+ * 所有键值对顺序写入一块连续缓冲区：每项为[键引用][值长度][值]，整数均为varint。
+ * 键引用为编号*2（字典中的键），或长度*2+1后跟键的字节（未收录的键）。
+ * 保存时一次分配（没有元数据时不分配），只在转换为模型时才展开为std::map
+ */
+class PackedMetadata {
+public:
+    PackedMetadata() = default;
+
+    /**
+     * @brief 打包元数据，键按std::map的顺序写入，展开后顺序不变
+     */
+    static PackedMetadata Pack(const std::map<std::string, std::string>& metadata,
+                               MetadataKeyDictionary& dictionary) {
+        PackedMetadata packed;
+        if (metadata.empty()) {
+            return packed;
+        }
+
+        // 先算出精确长度，缓冲区只分配一次；第二遍Intern只是查表，得到相同的编号
+        size_t size = 0;
+        for (const auto& entry : metadata) {
+            uint32_t id = dictionary.Intern(entry.first);
+            size += id != MetadataKeyDictionary::kNotFound
+                ? VarintSize(static_cast<uint64_t>(id) << 1)
+                : VarintSize(static_cast<uint64_t>(entry.first.size()) << 1) + entry.first.size();
+            size += VarintSize(entry.second.size()) + entry.second.size();
+        }
+        packed.buffer_.reserve(size);
+
+        for (const auto& entry : metadata) {
+            uint32_t id = dictionary.Intern(entry.first);
+            if (id != MetadataKeyDictionary::kNotFound) {
+                packed.AppendVarint(static_cast<uint64_t>(id) << 1);
+            } else {
+                packed.AppendVarint((static_cast<uint64_t>(entry.first.size()) << 1) | 1);
+                packed.buffer_.append(entry.first);
+            }
+            packed.AppendVarint(entry.second.size());
+            packed.buffer_.append(entry.second);
+        }
+        return packed;
+    }
+
+    /**
+     * @brief 展开为模型使用的std::map
+     */
+    std::map<std::string, std::string> ToMap(const MetadataKeyDictionary& dictionary) const {
+        std::map<std::string, std::string> metadata;
+        size_t pos = 0;
+        while (pos < buffer_.size()) {
+            uint64_t key_ref = ReadVarint(pos);
+            std::string key;
+            if (key_ref & 1) {
+                size_t length = static_cast<size_t>(key_ref >> 1);
+                key.assign(buffer_, pos, length);
+                pos += length;
+            } else {
+                key = dictionary.Key(static_cast<uint32_t>(key_ref >> 1));
+            }
+            size_t length = static_cast<size_t>(ReadVarint(pos));
+            metadata.emplace_hint(metadata.end(), std::move(key), buffer_.substr(pos, length));
+            pos += length;
+        }
+        return metadata;
+    }
+
+    bool Empty() const {
+        return buffer_.empty();
+    }
+
+private:
+    static size_t VarintSize(uint64_t value) {
+        size_t size = 1;
+        while (value >= 0x80) {
+            value >>= 7;
+            ++size;
+        }
+        return size;
+    }
+
+    void AppendVarint(uint64_t value) {
+        while (value >= 0x80) {
+            buffer_.push_back(static_cast<char>(static_cast<uint8_t>(value) | 0x80));
+            value >>= 7;
+        }
+        buffer_.push_back(static_cast<char>(value));
+    }
+
+    uint64_t ReadVarint(size_t& pos) const {
+        uint64_t value = 0;
+        for (int shift = 0; pos < buffer_.size(); shift += 7) {
+            uint8_t byte = static_cast<uint8_t>(buffer_[pos++]);
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                break;
+            }
+        }
+        return value;
+    }
+
+    std::string buffer_;
+};
+
+#endif // NOTIFICATION_METADATA_H
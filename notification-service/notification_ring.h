@@ -0,0 +1,169 @@
+#ifndef NOTIFICATION_RING_H
+#define NOTIFICATION_RING_H
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../common/id128.h"
+#include "../common/models.h"
+#include "notification_metadata.h"
+
+/**
+ * @brief 服务内部保存的通知记录
+ * 所属用户由所在的环形缓冲区确定，不逐条保存；元数据以紧凑形式保存，返回给调用方时才格式化为模型
+ */
+struct StoredNotification {
+    chat::Id128 notification_id;
+    uint64_t sequence = 0;  // 在所属用户环形缓冲区中的序号，从1开始递增，订阅游标据此定位
+    int64_t timestamp = 0;
+    bool is_read = false;
+    std::string title;
+    std::string content;
+    std::string type;
+    PackedMetadata metadata;
+
+    /**
+     * @param metadata_keys 打包元数据时使用的键字典
+     */
+    chat::models::Notification ToNotification(const std::string& user_id,
+                                              const MetadataKeyDictionary& metadata_keys) const {
+        chat::models::Notification notification;
+        notification.notification_id = notification_id.ToString();
+        notification.user_id = user_id;
+        notification.title = title;
+        notification.content = content;
+        notification.type = type;
+        notification.is_read = is_read;
+        notification.timestamp = timestamp;
+        notification.sequence = static_cast<int64_t>(sequence);
+        if (!metadata.Empty()) {
+            notification.metadata = metadata.ToMap(metadata_keys);
+        }
+        return notification;
+    }
+};
+
+/**
+ * @brief 单个用户的通知环形缓冲区，按写入顺序保存，最多保留capacity条
+ * 写满后新通知覆盖最早的一条，内存上限固定。时间戳不早于前一条（时钟回拨时取前一条的时间戳），
+ * 因此写入顺序即(时间戳, 序号)顺序：分页用二分定位游标，按序号订阅直接算出下标，
+ * 整体O(log n + limit)，不排序也不复制其余通知
+ */
+class NotificationRing {
+public:
+    /**
+     * @brief 一次分页查询的结果
+     */
+    struct Page {
+        std::vector<const StoredNotification*> notifications;  // Before最新的在前，After最早的在前
+        bool has_more = false;                                 // 本页之外是否还有符合条件的通知
+    };
+
+    explicit NotificationRing(size_t capacity)
+        : capacity_(capacity == 0 ? 1 : capacity), head_(0), last_sequence_(0) {}
+
+    /**
+     * @brief 追加一条通知并分配序号
+     * @return 保存后的通知（时间戳可能被调整为前一条的时间戳）
+     */
+    const StoredNotification& Append(StoredNotification notification) {
+        if (!entries_.empty()) {
+            notification.timestamp = std::max(notification.timestamp, At(entries_.size() - 1).timestamp);
+        }
+        notification.sequence = ++last_sequence_;
+
+        if (entries_.size() < capacity_) {
+            entries_.push_back(std::move(notification));
+            return entries_.back();
+        }
+        size_t slot = head_;
+        entries_[slot] = std::move(notification);
+        head_ = (head_ + 1) % capacity_;
+        return entries_[slot];
+    }
+
+    /**
+     * @brief 取排在游标(before_timestamp, before_sequence)之前的最新limit条通知
+     * 同一批发送的通知时间戳相同，只按时间戳翻页会跳过与上一页最后一条同一毫秒的通知，因此同时比较序号
+     * @param before_timestamp 游标，<=0表示从最新一条开始
+     * @param before_sequence 上一页最后一条的序号，0表示只返回早于before_timestamp的通知
+     * @param limit 最多返回条数，<=0表示不限
+     */
+    Page Before(int64_t before_timestamp, uint64_t before_sequence, int32_t limit) const {
+        size_t end = entries_.size();
+        if (before_timestamp > 0) {
+            size_t low = 0;
+            while (low < end) {
+                size_t mid = low + (end - low) / 2;
+                const StoredNotification& entry = At(mid);
+                if (entry.timestamp < before_timestamp ||
+                    (entry.timestamp == before_timestamp && entry.sequence < before_sequence)) {
+                    low = mid + 1;
+                } else {
+                    end = mid;
+                }
+            }
+        }
+
+        size_t count = (limit > 0 && static_cast<size_t>(limit) < end) ? static_cast<size_t>(limit) : end;
+
+        Page page;
+        page.has_more = count < end;
+        page.notifications.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            page.notifications.push_back(&At(end - 1 - i));
+        }
+        return page;
+    }
+
+    /**
+     * @brief 取序号大于cursor的最早limit条通知，结果按序号连续
+     * 游标早于保留范围时从保留的最早一条开始
+     * @param limit 最多返回条数，<=0表示不限
+     */
+    Page After(uint64_t cursor, int32_t limit) const {
+        uint64_t first_sequence = last_sequence_ - entries_.size() + 1;
+        size_t begin = 0;
+        if (cursor >= first_sequence) {
+            begin = static_cast<size_t>(std::min<uint64_t>(cursor - first_sequence + 1, entries_.size()));
+        }
+
+        size_t available = entries_.size() - begin;
+        size_t count = (limit > 0 && static_cast<size_t>(limit) < available) ? static_cast<size_t>(limit) : available;
+
+        Page page;
+        page.has_more = count < available;
+        page.notifications.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            page.notifications.push_back(&At(begin + i));
+        }
+        return page;
+    }
+
+    /**
+     * @brief 最近一条通知的序号，尚无通知时为0
+     */
+    uint64_t LastSequence() const {
+        return last_sequence_;
+    }
+
+    size_t Size() const {
+        return entries_.size();
+    }
+
+private:
+    // 逻辑下标0为最早的一条
+    const StoredNotification& At(size_t index) const {
+        return entries_[(head_ + index) % entries_.size()];
+    }
+
+    size_t capacity_;
+    size_t head_;                              // 写满后最早一条所在的物理下标
+    uint64_t last_sequence_;                   // 已分配的最大序号
+    std::vector<StoredNotification> entries_;  // 未写满前按需增长
+};
+
+#endif // NOTIFICATION_RING_H
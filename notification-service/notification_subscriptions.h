@@ -0,0 +1,217 @@
+#ifndef NOTIFICATION_SUBSCRIPTIONS_H
+#define NOTIFICATION_SUBSCRIPTIONS_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../common/id128.h"
+
+/**
+ * @brief 等待新通知的订阅登记表
+ * 订阅请求没有新通知可返回时在此登记一个回调，不占用工作线程。
+ * 回调在以下任一情况发生时被调用恰好一次：该用户有新通知（Notify）、等待到期（计时线程）、服务停止（Shutdown）。
+ * 回调总是在不持有登记表锁的情况下调用，可以在回调中获取调用方自己的锁
+ */
+class NotificationSubscriptions {
+public:
+    using Callback = std::function<void()>;
+    using Clock = std::chrono::steady_clock;
+
+    NotificationSubscriptions() : stopping_(false), next_id_(1) {
+        timer_thread_ = std::thread([this]() {
+            TimerLoop();
+        });
+    }
+
+    ~NotificationSubscriptions() {
+        Shutdown();
+    }
+
+    NotificationSubscriptions(const NotificationSubscriptions&) = delete;
+    NotificationSubscriptions& operator=(const NotificationSubscriptions&) = delete;
+
+    /**
+     * @brief 登记一个等待者
+     * @return 已停止时返回false，回调不会被调用，调用方应直接应答
+     */
+    bool Add(const chat::Id128& user_id, Clock::time_point deadline, Callback callback) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            return false;
+        }
+        uint64_t id = next_id_++;
+        auto deadline_it = deadlines_.emplace(deadline, id);
+        waiters_.emplace(id, Waiter{user_id, deadline_it, std::move(callback)});
+        by_user_[user_id].push_back(id);
+        if (deadline_it == deadlines_.begin()) {
+            timer_cv_.notify_one();
+        }
+        return true;
+    }
+
+    /**
+     * @brief 唤醒该用户的所有等待者
+     */
+    void Notify(const chat::Id128& user_id) {
+        std::vector<Callback> callbacks;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            TakeWaiters(user_id, callbacks);
+        }
+        for (auto& callback : callbacks) {
+            callback();
+        }
+    }
+
+    /**
+     * @brief 唤醒多个用户的所有等待者，只加一次锁
+     */
+    void Notify(const std::vector<chat::Id128>& user_ids) {
+        std::vector<Callback> callbacks;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (by_user_.empty()) {
+                return;
+            }
+            for (const auto& user_id : user_ids) {
+                TakeWaiters(user_id, callbacks);
+            }
+        }
+        for (auto& callback : callbacks) {
+            callback();
+        }
+    }
+
+    /**
+     * @brief 停止计时线程并唤醒所有等待者，之后的Add均返回false
+     */
+    void Shutdown() {
+        std::vector<Callback> callbacks;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_) {
+                return;
+            }
+            stopping_ = true;
+            callbacks.reserve(waiters_.size());
+            for (auto& entry : waiters_) {
+                callbacks.push_back(std::move(entry.second.callback));
+            }
+            waiters_.clear();
+            by_user_.clear();
+            deadlines_.clear();
+        }
+        timer_cv_.notify_one();
+        if (timer_thread_.joinable()) {
+            timer_thread_.join();
+        }
+        for (auto& callback : callbacks) {
+            callback();
+        }
+    }
+
+    /**
+     * @brief 当前等待中的订阅数
+     */
+    size_t Size() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return waiters_.size();
+    }
+
+private:
+    using DeadlineMap = std::multimap<Clock::time_point, uint64_t>;
+
+    struct Waiter {
+        chat::Id128 user_id;
+        DeadlineMap::iterator deadline;
+        Callback callback;
+    };
+
+    /**
+     * @brief 计时线程：按到期时间依次唤醒等待者
+     */
+    void TimerLoop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_) {
+            if (deadlines_.empty()) {
+                timer_cv_.wait(lock);
+                continue;
+            }
+            auto now = Clock::now();
+            if (deadlines_.begin()->first > now) {
+                timer_cv_.wait_until(lock, deadlines_.begin()->first);
+                continue;
+            }
+
+            std::vector<Callback> callbacks;
+            while (!deadlines_.empty() && deadlines_.begin()->first <= now) {
+                uint64_t id = deadlines_.begin()->second;
+                deadlines_.erase(deadlines_.begin());
+                auto waiter_it = waiters_.find(id);
+                RemoveFromUser(waiter_it->second.user_id, id);
+                callbacks.push_back(std::move(waiter_it->second.callback));
+                waiters_.erase(waiter_it);
+            }
+
+            lock.unlock();
+            for (auto& callback : callbacks) {
+                callback();
+            }
+            lock.lock();
+        }
+    }
+
+    /**
+     * @brief 取出该用户所有等待者的回调并注销，调用方需持有mutex_
+     */
+    void TakeWaiters(const chat::Id128& user_id, std::vector<Callback>& callbacks) {
+        auto user_it = by_user_.find(user_id);
+        if (user_it == by_user_.end()) {
+            return;
+        }
+        for (uint64_t id : user_it->second) {
+            auto waiter_it = waiters_.find(id);
+            deadlines_.erase(waiter_it->second.deadline);
+            callbacks.push_back(std::move(waiter_it->second.callback));
+            waiters_.erase(waiter_it);
+        }
+        by_user_.erase(user_it);
+    }
+
+    void RemoveFromUser(const chat::Id128& user_id, uint64_t id) {
+        auto user_it = by_user_.find(user_id);
+        if (user_it == by_user_.end()) {
+            return;
+        }
+        auto& ids = user_it->second;
+        for (size_t i = 0; i < ids.size(); ++i) {
+            if (ids[i] == id) {
+                ids[i] = ids.back();
+                ids.pop_back();
+                break;
+            }
+        }
+        if (ids.empty()) {
+            by_user_.erase(user_it);
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable timer_cv_;
+    bool stopping_;
+    uint64_t next_id_;
+    std::unordered_map<uint64_t, Waiter> waiters_;
+    std::unordered_map<chat::Id128, std::vector<uint64_t>, chat::Id128Hash> by_user_;
+    DeadlineMap deadlines_;  // 到期时间 -> 等待者
+    std::thread timer_thread_;
+};
+
+#endif // NOTIFICATION_SUBSCRIPTIONS_H
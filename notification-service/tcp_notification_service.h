@@ -3,11 +3,16 @@
 
 #include "../common/tcp_service_base.h"
 #include "../common/models.h"
+#include "../common/user_cache.h"
+#include "../common/id128.h"
+#include "notification_ring.h"
+#include "notification_subscriptions.h"
+#include <algorithm>
 #include <string>
-#include <map>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <mutex>
-#include <random>
 #include <chrono>
 
 /**
@@ -20,19 +25,27 @@ public:
      * @brief 构造函数
      */
     TcpNotificationService(const std::string& host, int port,
-                          const std::string& user_service_host, int user_service_port)
+                          const std::string& user_service_host, int user_service_port,
+                          size_t retention_per_user = 1000)
         : TcpServiceBase("notification-service", "1.0.0", host, port),
-          user_service_host_(user_service_host),
-          user_service_port_(user_service_port) {
-        // 初始化随机数生成器
-        std::random_device rd;
-        random_engine_ = std::mt19937(rd());
+          retention_per_user_(retention_per_user),
+          users_(user_service_host, user_service_port) {
     }
 
     /**
      * @brief 析构函数
      */
-    ~TcpNotificationService() = default;
+    ~TcpNotificationService() {
+        Stop();
+    }
+
+    /**
+     * @brief 停止服务：先应答所有等待中的订阅，再停止连接和工作线程
+     */
+    void Stop() override {
+        subscriptions_.Shutdown();
+        TcpServiceBase::Stop();
+    }
 
 protected:
     /**
@@ -47,6 +60,22 @@ protected:
             }
         );
 
+        // 注册批量发送通知处理器
+        RegisterHandler<chat::models::BulkNotificationRequest, chat::models::BulkNotificationResponse>(
+            "notification.send_bulk",
+            [this](const chat::models::BulkNotificationRequest& request) {
+                return SendBulkNotification(request);
+            }
+        );
+
+        // 注册通知批量提交处理器
+        RegisterHandler<chat::models::NotificationBatchRequest, chat::models::NotificationBatchResponse>(
+            "notification.send_batch",
+            [this](const chat::models::NotificationBatchRequest& request) {
+                return SendNotificationBatch(request);
+            }
+        );
+
         // 注册获取通知列表处理器
         RegisterHandler<chat::models::GetNotificationsRequest, chat::models::GetNotificationsResponse>(
             "notification.get",
@@ -54,6 +83,15 @@ protected:
                 return GetNotifications(request);
             }
         );
+
+        // 注册订阅通知处理器（长轮询，等待期间不占用工作线程）
+        RegisterAsyncHandler<chat::models::SubscribeNotificationsRequest, chat::models::SubscribeNotificationsResponse>(
+            "notification.subscribe",
+            [this](const chat::models::SubscribeNotificationsRequest& request,
+                   Responder<chat::models::SubscribeNotificationsResponse> respond) {
+                Subscribe(request, std::move(respond));
+            }
+        );
     }
 
 private:
@@ -64,16 +102,19 @@ private:
         auto scope = CreateSpan("notification_service.send_notification");
         auto span = GetCurrentSpan();
         
-        span->SetAttribute("user_id", request.user_id);
-        span->SetAttribute("notification_type", request.type);
-        span->SetAttribute("protocol", "tcp");
+        if (span->IsRecording()) {
+            span->SetAttribute("user_id", request.user_id);
+            span->SetAttribute("notification_type", request.type);
+            span->SetAttribute("protocol", "tcp");
+        }
         
         chat::models::NotificationResponse response;
         
         try {
             // 验证用户
             span->AddEvent("validating_user");
-            if (!ValidateUser(request.user_id)) {
+            chat::Id128 user_id;
+            if (!users_.Validate(request.user_id, user_id)) {
                 response.success = false;
                 response.message = "用户不存在";
                 span->SetStatus(trace::StatusCode::kError, "用户不存在");
@@ -82,31 +123,22 @@ private:
             
             std::unique_lock<std::mutex> lock(mutex_);
             
-            // 生成通知ID
-            std::string notification_id = GenerateUUID();
-            
-            // 创建通知
+            // 创建通知，存入用户的环形缓冲区，超出保留条数时覆盖最早的通知
             span->AddEvent("creating_notification");
-            chat::models::Notification notification;
-            notification.notification_id = notification_id;
-            notification.user_id = request.user_id;
-            notification.type = request.type;
-            notification.title = request.title;
-            notification.content = request.content;
-            notification.timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
-                std::chrono::system_clock::now().time_since_epoch()).count();
-            notification.is_read = false;
-            
-            // 存储通知
-            notifications_by_id_[notification_id] = notification;
-            notifications_by_user_[request.user_id].push_back(notification_id);
+            const StoredNotification& stored = RingFor(user_id).Append(NewNotification(
+                request.title, request.content, request.type, NowMillis(),
+                PackedMetadata::Pack(request.metadata, metadata_keys_)));
             
             response.success = true;
             response.message = "通知发送成功";
-            response.notification_id = notification_id;
-            response.timestamp = notification.timestamp;
+            response.notification_id = stored.notification_id.ToString();
+            response.timestamp = stored.timestamp;
+            lock.unlock();
+            
+            // 唤醒该用户等待中的订阅
+            subscriptions_.Notify(user_id);
             
-            span->SetAttribute("notification_id", notification_id);
+            span->SetAttribute("notification_id", response.notification_id);
             span->SetStatus(trace::StatusCode::kOk);
             span->AddEvent("notification_sent");
             
@@ -120,6 +152,181 @@ private:
         return response;
     }
 
+    /**
+     * @brief 批量发送同一条通知
+     * 收件人去重后一次批量校验（缓存未命中的合并为user.get_many调用），
+     * 再在一次加锁内写入所有收件人的环形缓冲区，最后一次性唤醒等待中的订阅
+     */
+    chat::models::BulkNotificationResponse SendBulkNotification(const chat::models::BulkNotificationRequest& request) {
+        auto scope = CreateSpan("notification_service.send_bulk_notification");
+        auto span = GetCurrentSpan();
+        
+        if (span->IsRecording()) {
+            span->SetAttribute("recipient_count", static_cast<int>(request.user_ids.size()));
+            span->SetAttribute("notification_type", request.type);
+            span->SetAttribute("protocol", "tcp");
+        }
+        
+        chat::models::BulkNotificationResponse response;
+        
+        if (request.user_ids.size() > kMaxBulkRecipients) {
+            response.success = false;
+            response.message = "单次最多发送给" + std::to_string(kMaxBulkRecipients) + "个用户";
+            span->SetStatus(trace::StatusCode::kError, response.message);
+            return response;
+        }
+        
+        try {
+            // 解析并去重，格式不正确的ID直接视为不存在
+            span->AddEvent("validating_users");
+            std::vector<chat::Id128> recipients;
+            std::vector<const std::string*> recipient_names;
+            std::unordered_set<chat::Id128, chat::Id128Hash> seen;
+            recipients.reserve(request.user_ids.size());
+            recipient_names.reserve(request.user_ids.size());
+            for (const auto& user_id : request.user_ids) {
+                chat::Id128 id;
+                if (!chat::Id128::Parse(user_id, id)) {
+                    response.failed_user_ids.push_back(user_id);
+                } else if (seen.insert(id).second) {
+                    recipients.push_back(id);
+                    recipient_names.push_back(&user_id);
+                }
+            }
+            
+            std::vector<bool> exists = users_.ValidateAll(recipients);
+            size_t valid_count = 0;
+            for (size_t i = 0; i < recipients.size(); ++i) {
+                if (exists[i]) {
+                    recipients[valid_count++] = recipients[i];
+                } else {
+                    response.failed_user_ids.push_back(*recipient_names[i]);
+                }
+            }
+            recipients.resize(valid_count);
+            
+            span->AddEvent("creating_notifications");
+            int64_t timestamp = NowMillis();
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                PackedMetadata metadata = PackedMetadata::Pack(request.metadata, metadata_keys_);
+                for (const auto& user_id : recipients) {
+                    RingFor(user_id).Append(
+                        NewNotification(request.title, request.content, request.type, timestamp, metadata));
+                }
+            }
+            
+            // 唤醒收件人等待中的订阅
+            subscriptions_.Notify(recipients);
+            
+            response.success = true;
+            response.message = "通知发送成功";
+            response.timestamp = timestamp;
+            response.delivered_count = static_cast<int32_t>(recipients.size());
+            
+            if (span->IsRecording()) {
+                span->SetAttribute("delivered_count", response.delivered_count);
+                span->SetAttribute("failed_count", static_cast<int>(response.failed_user_ids.size()));
+            }
+            span->SetStatus(trace::StatusCode::kOk);
+            span->AddEvent("notifications_sent");
+            
+        } catch (const std::exception& e) {
+            response.success = false;
+            response.message = std::string("发送通知失败: ") + e.what();
+            
+            span->SetStatus(trace::StatusCode::kError, e.what());
+        }
+        
+        return response;
+    }
+
+    /**
+     * @brief 批量提交多条独立的通知（供其他服务攒批投递）
+     * 所有收件人一次批量校验，通知在一次加锁内写入，最后一次性唤醒等待中的订阅
+     */
+    chat::models::NotificationBatchResponse SendNotificationBatch(const chat::models::NotificationBatchRequest& request) {
+        auto scope = CreateSpan("notification_service.send_notification_batch");
+        auto span = GetCurrentSpan();
+        
+        if (span->IsRecording()) {
+            span->SetAttribute("batch_size", static_cast<int>(request.notifications.size()));
+            span->SetAttribute("protocol", "tcp");
+        }
+        
+        chat::models::NotificationBatchResponse response;
+        
+        if (request.notifications.size() > kMaxBulkRecipients) {
+            response.success = false;
+            response.message = "单次最多提交" + std::to_string(kMaxBulkRecipients) + "条通知";
+            span->SetStatus(trace::StatusCode::kError, response.message);
+            return response;
+        }
+        
+        try {
+            // 解析收件人，同一用户的多条通知只校验一次
+            span->AddEvent("validating_users");
+            std::vector<chat::Id128> user_ids(request.notifications.size());
+            std::vector<bool> parsed(request.notifications.size(), false);
+            std::vector<chat::Id128> distinct;
+            std::unordered_set<chat::Id128, chat::Id128Hash> seen;
+            for (size_t i = 0; i < request.notifications.size(); ++i) {
+                parsed[i] = chat::Id128::Parse(request.notifications[i].user_id, user_ids[i]);
+                if (parsed[i] && seen.insert(user_ids[i]).second) {
+                    distinct.push_back(user_ids[i]);
+                }
+            }
+            
+            std::vector<bool> exists = users_.ValidateAll(distinct);
+            std::unordered_set<chat::Id128, chat::Id128Hash> valid;
+            std::vector<chat::Id128> delivered;
+            for (size_t i = 0; i < distinct.size(); ++i) {
+                if (exists[i]) {
+                    valid.insert(distinct[i]);
+                    delivered.push_back(distinct[i]);
+                }
+            }
+            
+            span->AddEvent("creating_notifications");
+            int64_t timestamp = NowMillis();
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                for (size_t i = 0; i < request.notifications.size(); ++i) {
+                    if (!parsed[i] || valid.count(user_ids[i]) == 0) {
+                        ++response.failed_count;
+                        continue;
+                    }
+                    const auto& notification = request.notifications[i];
+                    RingFor(user_ids[i]).Append(NewNotification(
+                        notification.title, notification.content, notification.type, timestamp,
+                        PackedMetadata::Pack(notification.metadata, metadata_keys_)));
+                    ++response.delivered_count;
+                }
+            }
+            
+            // 唤醒收件人等待中的订阅
+            subscriptions_.Notify(delivered);
+            
+            response.success = true;
+            response.message = "通知发送成功";
+            
+            if (span->IsRecording()) {
+                span->SetAttribute("delivered_count", response.delivered_count);
+                span->SetAttribute("failed_count", response.failed_count);
+            }
+            span->SetStatus(trace::StatusCode::kOk);
+            span->AddEvent("notifications_sent");
+            
+        } catch (const std::exception& e) {
+            response.success = false;
+            response.message = std::string("发送通知失败: ") + e.what();
+            
+            span->SetStatus(trace::StatusCode::kError, e.what());
+        }
+        
+        return response;
+    }
+
     /**
      * @brief 获取用户通知列表
      */
@@ -127,15 +334,18 @@ private:
         auto scope = CreateSpan("notification_service.get_notifications");
         auto span = GetCurrentSpan();
         
-        span->SetAttribute("user_id", request.user_id);
-        span->SetAttribute("protocol", "tcp");
+        if (span->IsRecording()) {
+            span->SetAttribute("user_id", request.user_id);
+            span->SetAttribute("protocol", "tcp");
+        }
         
         chat::models::GetNotificationsResponse response;
         
         try {
             // 验证用户
             span->AddEvent("validating_user");
-            if (!ValidateUser(request.user_id)) {
+            chat::Id128 user_id;
+            if (!users_.Validate(request.user_id, user_id)) {
                 response.success = false;
                 response.message = "用户不存在";
                 span->SetStatus(trace::StatusCode::kError, "用户不存在");
@@ -146,7 +356,7 @@ private:
             
             // 获取用户通知ID列表
             span->AddEvent("fetching_notifications");
-            auto user_it = notifications_by_user_.find(request.user_id);
+            auto user_it = notifications_by_user_.find(user_id);
             if (user_it == notifications_by_user_.end()) {
                 response.success = true;
                 response.total_count = 0;
@@ -154,26 +364,14 @@ private:
                 return response;
             }
             
-            std::vector<std::string> notification_ids = user_it->second;
-            
-            // 转换为通知对象
-            for (const auto& notif_id : notification_ids) {
-                auto notif_it = notifications_by_id_.find(notif_id);
-                if (notif_it != notifications_by_id_.end()) {
-                    response.notifications.push_back(notif_it->second);
-                }
-            }
-            
-            // 按时间排序（最新的在前）
-            std::sort(response.notifications.begin(), response.notifications.end(),
-                     [](const chat::models::Notification& a, const chat::models::Notification& b) {
-                         return a.timestamp > b.timestamp;
-                     });
-            
-            // 分页处理
-            if (request.limit > 0 && response.notifications.size() > request.limit) {
-                response.notifications.resize(request.limit);
+            // 从游标向前取最新的limit条（最新的在前），只转换返回的通知
+            uint64_t before_sequence = request.before_sequence > 0 ? static_cast<uint64_t>(request.before_sequence) : 0;
+            auto page = user_it->second.Before(request.before_timestamp, before_sequence, request.limit);
+            response.notifications.reserve(page.notifications.size());
+            for (const auto* notification : page.notifications) {
+                response.notifications.push_back(notification->ToNotification(request.user_id, metadata_keys_));
             }
+            response.has_more = page.has_more;
             
             response.success = true;
             response.total_count = static_cast<int>(response.notifications.size());
@@ -193,57 +391,138 @@ private:
     }
 
     /**
-     * @brief 验证用户是否存在（通过TCP调用user-service）
+     * @brief 订阅通知（长轮询）
+     * 已有序号大于游标的通知时立即返回；否则登记等待，有新通知或等待到期时由其他线程应答
      */
-    bool ValidateUser(const std::string& user_id) {
-        try {
-            // 构造获取用户请求
-            chat::models::GetUserRequest request;
-            request.user_id = user_id;
-            
-            // 通过TCP调用user-service
-            auto response = SendTcpRequest<chat::models::GetUserRequest, chat::models::UserInfo>(
-                user_service_host_, user_service_port_, "user.get", request
-            );
-            
-            return response.success;
-            
-        } catch (const std::exception& e) {
-            std::cerr << "验证用户失败: " << e.what() << std::endl;
-            return false;
+    void Subscribe(const chat::models::SubscribeNotificationsRequest& request,
+                   Responder<chat::models::SubscribeNotificationsResponse> respond) {
+        auto scope = CreateSpan("notification_service.subscribe");
+        auto span = GetCurrentSpan();
+        
+        if (span->IsRecording()) {
+            span->SetAttribute("user_id", request.user_id);
+            span->SetAttribute("cursor", request.cursor);
+            span->SetAttribute("wait_ms", request.wait_ms);
+            span->SetAttribute("protocol", "tcp");
         }
+        
+        chat::models::SubscribeNotificationsResponse response;
+        
+        // 验证用户
+        span->AddEvent("validating_user");
+        chat::Id128 user_id;
+        if (!users_.Validate(request.user_id, user_id)) {
+            response.success = false;
+            response.message = "用户不存在";
+            span->SetStatus(trace::StatusCode::kError, "用户不存在");
+            respond(response);
+            return;
+        }
+        
+        int32_t wait_ms = std::min(std::max(request.wait_ms, 0), kMaxSubscribeWaitMs);
+        auto deadline = NotificationSubscriptions::Clock::now() + std::chrono::milliseconds(wait_ms);
+        
+        std::unique_lock<std::mutex> lock(mutex_);
+        const NotificationRing& ring = RingFor(user_id);
+        
+        // 负游标表示从现在开始；游标超过已分配的序号说明服务重启过，从保留的最早一条开始
+        uint64_t cursor = request.cursor < 0 ? ring.LastSequence() : static_cast<uint64_t>(request.cursor);
+        if (cursor > ring.LastSequence()) {
+            cursor = 0;
+        }
+        
+        bool waiting = wait_ms > 0 && ring.LastSequence() == cursor &&
+            subscriptions_.Add(user_id, deadline, [this, user_id, user = request.user_id, cursor,
+                                                   limit = request.limit, respond]() {
+                std::unique_lock<std::mutex> lock(mutex_);
+                auto response = CollectAfter(RingFor(user_id), metadata_keys_, user, cursor, limit);
+                lock.unlock();
+                respond(response);
+            });
+        if (waiting) {
+            span->AddEvent("waiting_for_notifications");
+            span->SetStatus(trace::StatusCode::kOk);
+            return;
+        }
+        
+        response = CollectAfter(ring, metadata_keys_, request.user_id, cursor, request.limit);
+        lock.unlock();
+        
+        span->SetAttribute("notification_count", static_cast<int>(response.notifications.size()));
+        span->SetStatus(trace::StatusCode::kOk);
+        respond(response);
     }
 
     /**
-     * @brief 生成UUID
+     * @brief 组装序号大于游标的通知，调用方需持有mutex_
      */
-    std::string GenerateUUID() {
-        std::uniform_int_distribution<> dis(0, 15);
-        std::stringstream ss;
-        ss << std::hex;
-        
-        for (int i = 0; i < 32; ++i) {
-            if (i == 8 || i == 12 || i == 16 || i == 20) {
-                ss << "-";
-            }
-            ss << dis(random_engine_);
+    static chat::models::SubscribeNotificationsResponse CollectAfter(const NotificationRing& ring,
+                                                                     const MetadataKeyDictionary& metadata_keys,
+                                                                     const std::string& user_id,
+                                                                     uint64_t cursor, int32_t limit) {
+        chat::models::SubscribeNotificationsResponse response;
+        auto page = ring.After(cursor, limit);
+        response.notifications.reserve(page.notifications.size());
+        for (const auto* notification : page.notifications) {
+            response.notifications.push_back(notification->ToNotification(user_id, metadata_keys));
         }
-        
-        return ss.str();
+        response.cursor = static_cast<int64_t>(
+            page.notifications.empty() ? cursor : page.notifications.back()->sequence);
+        response.has_more = page.has_more;
+        response.success = true;
+        return response;
+    }
+
+    /**
+     * @brief 构造一条未读的新通知
+     */
+    static StoredNotification NewNotification(const std::string& title, const std::string& content,
+                                              const std::string& type, int64_t timestamp,
+                                              PackedMetadata metadata) {
+        StoredNotification notification;
+        notification.notification_id = chat::Id128::Generate();
+        notification.type = type;
+        notification.title = title;
+        notification.content = content;
+        notification.timestamp = timestamp;
+        notification.is_read = false;
+        notification.metadata = std::move(metadata);
+        return notification;
     }
 
-    // 通知存储
-    std::map<std::string, chat::models::Notification> notifications_by_id_;
-    // 按用户ID存储通知ID
-    std::map<std::string, std::vector<std::string>> notifications_by_user_;
+    static int64_t NowMillis() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    /**
+     * @brief 用户的环形缓冲区，不存在时创建，调用方需持有mutex_
+     */
+    NotificationRing& RingFor(const chat::Id128& user_id) {
+        auto ring_it = notifications_by_user_.find(user_id);
+        if (ring_it == notifications_by_user_.end()) {
+            ring_it = notifications_by_user_.emplace(user_id, NotificationRing(retention_per_user_)).first;
+        }
+        return ring_it->second;
+    }
+
+    // 按用户保存的通知（按时间排序的环形缓冲区）
+    std::unordered_map<chat::Id128, NotificationRing, chat::Id128Hash> notifications_by_user_;
+    // 元数据键字典，与通知一样由mutex_保护
+    MetadataKeyDictionary metadata_keys_;
     // 互斥锁
     std::mutex mutex_;
-    // 随机数生成器
-    std::mt19937 random_engine_;
     
-    // user-service连接信息
-    std::string user_service_host_;
-    int user_service_port_;
+    // 每个用户最多保留的通知数
+    size_t retention_per_user_;
+    // 经缓存向user-service校验用户
+    UserServiceValidator users_;
+    // 等待新通知的订阅
+    NotificationSubscriptions subscriptions_;
+    
+    // 单次订阅的最长等待时间，低于网关调用后端的超时
+    static constexpr int32_t kMaxSubscribeWaitMs = 25000;
+    static constexpr size_t kMaxBulkRecipients = 10000;  // send_bulk的收件人数、send_batch的通知数上限
 };
 
 #endif // TCP_NOTIFICATION_SERVICE_H
\ No newline at end of file
@@ -49,6 +49,8 @@ int main(int argc, char* argv[]) {
         std::cout << "- user.register: 用户注册" << std::endl;
         std::cout << "- user.login: 用户登录" << std::endl;
         std::cout << "- user.get: 获取用户信息" << std::endl;
+        std::cout << "- user.get_many: 批量获取用户信息" << std::endl;
+        std::cout << "- user.auth: 令牌认证" << std::endl;
         std::cout << "按 Ctrl+C 停止服务" << std::endl;
         
         // 等待服务结束
@@ -3,10 +3,9 @@
 
 #include "../common/tcp_service_base.h"
 #include "../common/models.h"
+#include "../common/random_source.h"
+#include "user_store.h"
 #include <string>
-#include <map>
-#include <mutex>
-#include <random>
 #include <chrono>
 
 /**
@@ -20,9 +19,6 @@ public:
      */
     TcpUserService(const std::string& host, int port)
         : TcpServiceBase("user-service", "1.0.0", host, port) {
-        // 初始化随机数生成器
-        std::random_device rd;
-        random_engine_ = std::mt19937(rd());
     }
 
     /**
@@ -58,6 +54,22 @@ protected:
                 return GetUser(request.user_id);
             }
         );
+
+        // 注册批量获取用户信息处理器
+        RegisterHandler<chat::models::GetUsersRequest, chat::models::GetUsersResponse>(
+            "user.get_many",
+            [this](const chat::models::GetUsersRequest& request) {
+                return GetUsers(request);
+            }
+        );
+
+        // 注册令牌认证处理器
+        RegisterHandler<chat::models::AuthRequest, chat::models::AuthResponse>(
+            "user.auth",
+            [this](const chat::models::AuthRequest& request) {
+                return Authenticate(request);
+            }
+        );
     }
 
 private:
@@ -69,9 +81,11 @@ private:
         auto scope = CreateSpan("user_service.register");
         auto span = GetCurrentSpan();
         
-        span->SetAttribute("username", request.username);
-        span->SetAttribute("email", request.email);
-        span->SetAttribute("protocol", "tcp");
+        if (span->IsRecording()) {
+            span->SetAttribute("username", request.username);
+            span->SetAttribute("email", request.email);
+            span->SetAttribute("protocol", "tcp");
+        }
         
         // 在关键操作前添加一个事件
         span->AddEvent("validating_registration");
@@ -79,10 +93,8 @@ private:
         chat::models::RegisterResponse response;
         
         try {
-            std::unique_lock<std::mutex> lock(mutex_);
-            
-            // 检查用户名是否存在
-            if (users_by_username_.find(request.username) != users_by_username_.end()) {
+            // 检查用户名是否存在（只读快速路径，最终以插入结果为准）
+            if (store_.FindByUsername(request.username)) {
                 response.success = false;
                 response.message = "用户名已存在";
                 
@@ -91,8 +103,8 @@ private:
                 return response;
             }
             
-            // 生成用户ID
-            std::string user_id = GenerateUUID();
+            // 生成用户ID（按时间排序的128位ID，只在响应中格式化为字符串）
+            chat::Id128 user_id = chat::Id128::Generate();
             
             // 记录用户注册
             span->AddEvent("creating_user_record");
@@ -104,22 +116,29 @@ private:
             user.email = request.email;
             user.password = request.password; // 实际应用中应该哈希密码
             user.status = "active";
-            user.token = GenerateAuthToken();
+            user.token = chat::GenerateToken();
             user.created_at = std::chrono::duration_cast<std::chrono::milliseconds>(
                 std::chrono::system_clock::now().time_since_epoch()).count();
             user.last_active = user.created_at;
             
-            // 存储用户数据
-            users_by_id_[user_id] = user;
-            users_by_username_[request.username] = user_id;
-            
             // 构造响应
+            response.user_id = user_id.ToString();
+            response.token = user.token;
+            
+            // 存储用户数据，并发注册同一用户名时只有一个能成功
+            if (!store_.Insert(std::move(user))) {
+                response = chat::models::RegisterResponse();
+                response.success = false;
+                response.message = "用户名已存在";
+                
+                span->SetStatus(trace::StatusCode::kError, "用户名已存在");
+                return response;
+            }
+            
             response.success = true;
             response.message = "注册成功";
-            response.user_id = user_id;
-            response.token = user.token;
             
-            span->SetAttribute("user_id", user_id);
+            span->SetAttribute("user_id", response.user_id);
             span->SetStatus(trace::StatusCode::kOk);
             span->AddEvent("user_registered");
             
@@ -128,9 +147,11 @@ private:
             response.message = std::string("注册失败: ") + e.what();
             
             span->SetStatus(trace::StatusCode::kError, e.what());
-            span->AddEvent("registration_failed", {
-                {"error", e.what()}
-            });
+            if (span->IsRecording()) {
+                span->AddEvent("registration_failed", {
+                    {"error", e.what()}
+                });
+            }
         }
         
         return response;
@@ -144,18 +165,18 @@ private:
         auto scope = CreateSpan("user_service.login");
         auto span = GetCurrentSpan();
         
-        span->SetAttribute("username", request.username);
-        span->SetAttribute("protocol", "tcp");
+        if (span->IsRecording()) {
+            span->SetAttribute("username", request.username);
+            span->SetAttribute("protocol", "tcp");
+        }
         span->AddEvent("validating_credentials");
         
         chat::models::LoginResponse response;
         
         try {
-            std::unique_lock<std::mutex> lock(mutex_);
-            
             // 查找用户
-            auto username_it = users_by_username_.find(request.username);
-            if (username_it == users_by_username_.end()) {
+            auto found = store_.FindByUsername(request.username);
+            if (!found) {
                 response.success = false;
                 response.message = "用户不存在";
                 
@@ -163,20 +184,8 @@ private:
                 return response;
             }
             
-            std::string user_id = username_it->second;
-            auto user_it = users_by_id_.find(user_id);
-            if (user_it == users_by_id_.end()) {
-                response.success = false;
-                response.message = "用户数据不一致";
-                
-                span->SetStatus(trace::StatusCode::kError, "用户数据不一致");
-                return response;
-            }
-            
-            UserData& user = user_it->second;
-            
             // 验证密码
-            if (user.password != request.password) {
+            if (found->password != request.password) {
                 response.success = false;
                 response.message = "密码错误";
                 
@@ -186,18 +195,26 @@ private:
             }
             
             // 更新最后活跃时间
-            user.last_active = std::chrono::duration_cast<std::chrono::milliseconds>(
+            int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
                 std::chrono::system_clock::now().time_since_epoch()).count();
+            auto user = store_.Touch(found->user_id, now);
+            if (!user) {
+                response.success = false;
+                response.message = "用户数据不一致";
+                
+                span->SetStatus(trace::StatusCode::kError, "用户数据不一致");
+                return response;
+            }
             
             // 构造响应
             response.success = true;
             response.message = "登录成功";
-            response.user_id = user.user_id;
-            response.token = user.token;
-            response.username = user.username;
-            response.email = user.email;
+            response.user_id = user->user_id.ToString();
+            response.token = user->token;
+            response.username = user->username;
+            response.email = user->email;
             
-            span->SetAttribute("user_id", user.user_id);
+            span->SetAttribute("user_id", response.user_id);
             span->SetStatus(trace::StatusCode::kOk);
             span->AddEvent("user_authenticated");
             
@@ -219,16 +236,18 @@ private:
         auto scope = CreateSpan("user_service.get_user");
         auto span = GetCurrentSpan();
         
-        span->SetAttribute("user_id", user_id);
-        span->SetAttribute("protocol", "tcp");
+        if (span->IsRecording()) {
+            span->SetAttribute("user_id", user_id);
+            span->SetAttribute("protocol", "tcp");
+        }
         
         chat::models::UserInfo userInfo;
         
         try {
-            std::unique_lock<std::mutex> lock(mutex_);
-            
-            auto it = users_by_id_.find(user_id);
-            if (it == users_by_id_.end()) {
+            // 只在一个分片上持有共享锁，取得记录指针后即释放；格式不正确的ID不可能存在
+            chat::Id128 id;
+            auto found = chat::Id128::Parse(user_id, id) ? store_.FindById(id) : nullptr;
+            if (!found) {
                 userInfo.success = false;
                 userInfo.message = "用户不存在";
                 
@@ -236,16 +255,8 @@ private:
                 return userInfo;
             }
             
-            const UserData& user = it->second;
-            
             // 构造用户信息
-            userInfo.success = true;
-            userInfo.user_id = user.user_id;
-            userInfo.username = user.username;
-            userInfo.email = user.email;
-            userInfo.status = user.status;
-            userInfo.created_at = user.created_at;
-            userInfo.last_active = user.last_active;
+            FillUserInfo(*found, userInfo);
             
             span->SetStatus(trace::StatusCode::kOk);
             span->AddEvent("user_info_retrieved");
@@ -261,54 +272,102 @@ private:
     }
 
     /**
-     * @brief 生成UUID
+     * @brief 批量获取用户信息
+     * 结果与请求的ID按顺序一一对应，不存在的用户对应项success为false
      */
-    std::string GenerateUUID() {
-        std::uniform_int_distribution<> dis(0, 15);
-        std::stringstream ss;
-        ss << std::hex;
+    chat::models::GetUsersResponse GetUsers(const chat::models::GetUsersRequest& request) {
+        auto scope = CreateSpan("user_service.get_users");
+        auto span = GetCurrentSpan();
+        
+        if (span->IsRecording()) {
+            span->SetAttribute("user_count", static_cast<int>(request.user_ids.size()));
+            span->SetAttribute("protocol", "tcp");
+        }
+        
+        chat::models::GetUsersResponse response;
+        
+        if (request.user_ids.size() > kMaxBatchSize) {
+            response.success = false;
+            response.message = "单次最多查询" + std::to_string(kMaxBatchSize) + "个用户";
+            span->SetStatus(trace::StatusCode::kError, response.message);
+            return response;
+        }
         
-        for (int i = 0; i < 32; ++i) {
-            if (i == 8 || i == 12 || i == 16 || i == 20) {
-                ss << "-";
+        response.users.resize(request.user_ids.size());
+        int found_count = 0;
+        for (size_t i = 0; i < request.user_ids.size(); ++i) {
+            chat::models::UserInfo& userInfo = response.users[i];
+            chat::Id128 id;
+            auto found = chat::Id128::Parse(request.user_ids[i], id) ? store_.FindById(id) : nullptr;
+            if (!found) {
+                userInfo.success = false;
+                userInfo.message = "用户不存在";
+                userInfo.user_id = request.user_ids[i];
+                userInfo.created_at = 0;
+                userInfo.last_active = 0;
+                continue;
             }
-            ss << dis(random_engine_);
+            FillUserInfo(*found, userInfo);
+            ++found_count;
         }
         
-        return ss.str();
+        response.success = true;
+        if (span->IsRecording()) {
+            span->SetAttribute("found_count", found_count);
+        }
+        span->SetStatus(trace::StatusCode::kOk);
+        return response;
     }
 
     /**
-     * @brief 生成认证令牌
+     * @brief 令牌认证：按令牌索引查找用户
+     * 只读路径，不更新最后活跃时间，网关可以高频调用
      */
-    std::string GenerateAuthToken() {
-        std::uniform_int_distribution<> dis(0, 61);
-        const std::string chars = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+    chat::models::AuthResponse Authenticate(const chat::models::AuthRequest& request) {
+        auto scope = CreateSpan("user_service.authenticate");
+        auto span = GetCurrentSpan();
+        
+        if (span->IsRecording()) {
+            span->SetAttribute("protocol", "tcp");
+        }
+        
+        chat::models::AuthResponse response;
         
-        std::string token;
-        for (int i = 0; i < 32; ++i) {
-            token += chars[dis(random_engine_)];
+        auto found = request.token.empty() ? nullptr : store_.FindByToken(request.token);
+        if (!found) {
+            response.success = false;
+            response.message = "认证令牌无效";
+            span->SetStatus(trace::StatusCode::kError, "认证令牌无效");
+            return response;
         }
         
-        return token;
+        response.success = true;
+        response.user_id = found->user_id.ToString();
+        response.username = found->username;
+        
+        if (span->IsRecording()) {
+            span->SetAttribute("user_id", response.user_id);
+        }
+        span->SetStatus(trace::StatusCode::kOk);
+        return response;
+    }
+
+    /**
+     * @brief 用用户记录填充对外的用户信息
+     */
+    static void FillUserInfo(const UserData& user, chat::models::UserInfo& userInfo) {
+        userInfo.success = true;
+        userInfo.user_id = user.user_id.ToString();
+        userInfo.username = user.username;
+        userInfo.email = user.email;
+        userInfo.status = user.status;
+        userInfo.created_at = user.created_at;
+        userInfo.last_active = user.last_active;
     }
 
-    // 用户数据结构
-    struct UserData {
-        std::string user_id;
-        std::string username;
-        std::string email;
-        std::string password;
-        std::string status;
-        std::string token;
-        int64_t created_at;
-        int64_t last_active;
-    };
+    static constexpr size_t kMaxBatchSize = 1000;       // user.get_many单次请求的ID数上限
 
-    std::map<std::string, UserData> users_by_id_;        // 按ID索引用户
-    std::map<std::string, std::string> users_by_username_; // 按用户名索引用户ID
-    std::mutex mutex_;                                  // 保护用户数据的互斥锁
-    std::mt19937 random_engine_;                        // 随机数生成器
+    ShardedUserStore store_;                            // 分片用户仓库
 };
 
 #endif // TCP_USER_SERVICE_H
\ No newline at end of file
@@ -0,0 +1,193 @@
+#ifndef USER_STORE_H
+#define USER_STORE_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../common/id128.h"
+
+/**
+ * @brief 用户数据
+ * 存入仓库后不再原地修改：更新时复制一份新记录替换指针，读者持有的旧指针始终有效
+ */
+struct UserData {
+    chat::Id128 user_id;
+    std::string username;
+    std::string email;
+    std::string password;
+    std::string status;
+    std::string token;
+    int64_t created_at = 0;
+    int64_t last_active = 0;
+};
+
+/**
+ * @brief 按键哈希分片的并发哈希表
+ * 每个分片一把读写锁，读操作只持有共享锁并复制出值（通常是shared_ptr），
+ * 不同分片上的读写互不影响
+ */
+template<typename Key, typename Value, typename Hash = std::hash<Key>>
+class ShardedMap {
+public:
+    explicit ShardedMap(size_t shard_count)
+        : shards_(RoundUpPowerOfTwo(shard_count)), mask_(shards_.size() - 1) {}
+
+    bool Find(const Key& key, Value& value) const {
+        const Shard& shard = ShardFor(key);
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.map.find(key);
+        if (it == shard.map.end()) {
+            return false;
+        }
+        value = it->second;
+        return true;
+    }
+
+    /**
+     * @brief 键不存在时插入，已存在时返回false
+     */
+    bool InsertIfAbsent(const Key& key, Value value) {
+        Shard& shard = ShardFor(key);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        return shard.map.emplace(key, std::move(value)).second;
+    }
+
+    /**
+     * @brief 在分片写锁内读取并替换已有的值
+     * @param update 接收旧值、返回新值
+     * @return 键不存在时返回false
+     */
+    template<typename Func>
+    bool Update(const Key& key, Func&& update) {
+        Shard& shard = ShardFor(key);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.map.find(key);
+        if (it == shard.map.end()) {
+            return false;
+        }
+        it->second = update(it->second);
+        return true;
+    }
+
+    void Erase(const Key& key) {
+        Shard& shard = ShardFor(key);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        shard.map.erase(key);
+    }
+
+private:
+    // 分片按缓存行对齐，相邻分片的锁不会伪共享
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<Key, Value, Hash> map;
+    };
+
+    static size_t RoundUpPowerOfTwo(size_t value) {
+        size_t result = 1;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    Shard& ShardFor(const Key& key) {
+        return shards_[Hash()(key) & mask_];
+    }
+
+    const Shard& ShardFor(const Key& key) const {
+        return shards_[Hash()(key) & mask_];
+    }
+
+    std::vector<Shard> shards_;
+    size_t mask_;
+};
+
+/**
+ * @brief 读多写少的用户仓库
+ * 按用户ID、用户名和认证令牌各维护一张分片表，记录以不可变的shared_ptr保存：
+ * user.get只在一个分片上持有共享锁复制指针，注册、登录等写操作只锁住涉及的分片
+ */
+class ShardedUserStore {
+public:
+    using UserPtr = std::shared_ptr<const UserData>;
+
+    explicit ShardedUserStore(size_t shard_count = 64)
+        : users_by_id_(shard_count), user_ids_by_username_(shard_count), user_ids_by_token_(shard_count) {}
+
+    UserPtr FindById(const chat::Id128& user_id) const {
+        UserPtr user;
+        users_by_id_.Find(user_id, user);
+        return user;
+    }
+
+    UserPtr FindByUsername(const std::string& username) const {
+        chat::Id128 user_id;
+        if (!user_ids_by_username_.Find(username, user_id)) {
+            return nullptr;
+        }
+        return FindById(user_id);
+    }
+
+    UserPtr FindByToken(const std::string& token) const {
+        chat::Id128 user_id;
+        if (!user_ids_by_token_.Find(token, user_id)) {
+            return nullptr;
+        }
+        return FindById(user_id);
+    }
+
+    /**
+     * @brief 插入新用户
+     * 先占用用户名和令牌，最后才写入ID表：竞争失败的注册从未对user.get可见，不会被下游缓存。
+     * 占用之后、写入ID表之前，按用户名或令牌查找会暂时查不到记录，与注册尚未完成时一致
+     * @return 用户名已被占用或令牌重复时返回false，仓库保持不变
+     */
+    bool Insert(UserData user) {
+        chat::Id128 user_id = user.user_id;
+        std::string username = user.username;
+        std::string token = user.token;
+        if (!user_ids_by_username_.InsertIfAbsent(username, user_id)) {
+            return false;
+        }
+        if (!token.empty() && !user_ids_by_token_.InsertIfAbsent(token, user_id)) {
+            user_ids_by_username_.Erase(username);
+            return false;
+        }
+        if (!users_by_id_.InsertIfAbsent(user_id, std::make_shared<const UserData>(std::move(user)))) {
+            if (!token.empty()) {
+                user_ids_by_token_.Erase(token);
+            }
+            user_ids_by_username_.Erase(username);
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief 更新最后活跃时间（复制记录后替换）
+     * @return 更新后的记录，用户不存在时返回nullptr
+     */
+    UserPtr Touch(const chat::Id128& user_id, int64_t last_active) {
+        UserPtr updated;
+        users_by_id_.Update(user_id, [&](const UserPtr& current) {
+            auto copy = std::make_shared<UserData>(*current);
+            copy->last_active = last_active;
+            updated = copy;
+            return updated;
+        });
+        return updated;
+    }
+
+private:
+    ShardedMap<chat::Id128, UserPtr, chat::Id128Hash> users_by_id_;     // 按ID索引用户
+    ShardedMap<std::string, chat::Id128> user_ids_by_username_;         // 按用户名索引用户ID
+    ShardedMap<std::string, chat::Id128> user_ids_by_token_;            // 按认证令牌索引用户ID
+};
+
+#endif // USER_STORE_H